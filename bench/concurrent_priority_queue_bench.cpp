@@ -0,0 +1,160 @@
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <mutex>
+#include <queue>
+#include <random>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "concurrent_priority_queue.hpp"
+
+// Baseline: the single mutex-guarded heap this queue is meant to replace.
+class LockedPriorityQueue
+{
+private:
+    std::priority_queue<std::pair<int64_t, int>> _heap;
+    std::mutex                                   _mtx;
+
+public:
+    void push(const int& value, int64_t priority)
+    {
+        std::lock_guard<std::mutex> lock(_mtx);
+        _heap.push({priority, value});
+    }
+
+    bool try_pop(int& dest)
+    {
+        std::lock_guard<std::mutex> lock(_mtx);
+        if (_heap.empty())
+            return false;
+        dest = _heap.top().second;
+        _heap.pop();
+        return true;
+    }
+};
+
+// Fenwick tree over priorities, used to count how many better elements were still queued.
+class RankCounter
+{
+private:
+    std::vector<int> _tree;
+
+public:
+    RankCounter(size_t size) : _tree(size + 1, 0) {}
+
+    void add(size_t index, int delta)
+    {
+        for (++index; index < _tree.size(); index += index & -index)
+            _tree[index] += delta;
+    }
+
+    int prefix(size_t index) const
+    {
+        int sum = 0;
+        for (++index; index > 0; index -= index & -index)
+            sum += _tree[index];
+        return sum;
+    }
+};
+
+template <typename TQueue>
+double throughput(size_t threads, size_t opsPerThread)
+{
+    TQueue queue;
+    for (int i = 0; i < 100000; ++i)
+        queue.push(i, i % 1024);
+
+    std::atomic<bool>        go{false};
+    std::vector<std::thread> workers;
+    for (size_t t = 0; t < threads; ++t)
+    {
+        workers.emplace_back(
+            [&, t]()
+            {
+                std::mt19937 rng(t);
+                int          value;
+                while (!go.load())
+                    ;
+                for (size_t i = 0; i < opsPerThread; ++i)
+                {
+                    if (i & 1)
+                        queue.try_pop(value);
+                    else
+                        queue.push(static_cast<int>(i), rng() % 1024);
+                }
+            });
+    }
+    auto start = std::chrono::steady_clock::now();
+    go.store(true);
+    for (auto& w : workers)
+        w.join();
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    return threads * opsPerThread / elapsed.count() / 1e6;
+}
+
+// Prefill a permutation of priorities, drain it from %threads consumers, then replay the pops in
+// ticket order to measure how many higher priority elements were still queued at each pop.
+void rankError(size_t threads, size_t elements)
+{
+    ConcurrentPriorityQueue<int> queue;
+    std::vector<int>             priorities(elements);
+    for (size_t i = 0; i < elements; ++i)
+        priorities[i] = static_cast<int>(i);
+    std::shuffle(priorities.begin(), priorities.end(), std::mt19937(42));
+    for (int p : priorities)
+        queue.push(p, p);
+
+    std::vector<int>         order(elements);
+    std::atomic<size_t>      ticket{0};
+    std::vector<std::thread> consumers;
+    for (size_t t = 0; t < threads; ++t)
+    {
+        consumers.emplace_back(
+            [&]()
+            {
+                int value;
+                while (queue.try_pop(value))
+                    order[ticket.fetch_add(1)] = value;
+            });
+    }
+    for (auto& c : consumers)
+        c.join();
+
+    RankCounter remaining(elements);
+    for (size_t i = 0; i < elements; ++i)
+        remaining.add(i, 1);
+
+    double sum = 0;
+    int    max = 0;
+    for (size_t i = 0; i < elements; ++i)
+    {
+        int rank = remaining.prefix(elements - 1) - remaining.prefix(order[i]);
+        remaining.add(order[i], -1);
+        sum += rank;
+        max = std::max(max, rank);
+    }
+    std::printf("rank error  threads=%-3zu mean=%8.2f max=%d\n", threads, sum / elements, max);
+}
+
+int main()
+{
+    const size_t hw  = std::max(1u, std::thread::hardware_concurrency());
+    const size_t ops = 1000000;
+
+    std::printf("%-8s %18s %18s\n", "threads", "multiqueue Mops/s", "locked heap Mops/s");
+    for (size_t threads = 1; threads <= hw; threads *= 2)
+    {
+        std::printf("%-8zu %18.2f %18.2f\n",
+                    threads,
+                    throughput<ConcurrentPriorityQueue<int>>(threads, ops),
+                    throughput<LockedPriorityQueue>(threads, ops));
+    }
+
+    for (size_t threads = 1; threads <= hw; threads *= 2)
+        rankError(threads, 1000000);
+    return 0;
+}
@@ -0,0 +1,74 @@
+#include <chrono>
+#include <cstddef>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <streambuf>
+
+#include "thread_safe_iostream.hpp"
+
+namespace
+{
+class NullBuffer : public std::streambuf
+{
+protected:
+    int overflow(int c) override
+    {
+        return c;
+    }
+
+    std::streamsize xsputn(const char*, std::streamsize count) override
+    {
+        return count;
+    }
+};
+
+template <typename TFunc>
+double nanosecondsPerCall(size_t count, TFunc&& func)
+{
+    auto start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < count; ++i)
+        func(i);
+    std::chrono::duration<double, std::nano> elapsed = std::chrono::steady_clock::now() - start;
+    return elapsed.count() / static_cast<double>(count);
+}
+
+double syncMilliseconds()
+{
+    auto start = std::chrono::steady_clock::now();
+    ThreadSafeIOStream::sync();
+    std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+    return elapsed.count();
+}
+} // namespace
+
+// Usage: log_bench [lines] (default 1000000)
+// Cost of one line on the logging thread; output goes to a null stream.
+int main(int argc, char** argv)
+{
+    size_t lines = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 1000000;
+
+    NullBuffer      null;
+    std::streambuf* stdoutBuffer = std::cout.rdbuf(&null);
+    ThreadSafeIO.setPrefix("[bench] ");
+
+    auto text     = [](size_t i) { ThreadSafeIO << "line " << i << " took " << 1.5 << std::endl; };
+    auto deferred = [](size_t i) { ThreadSafeIO.log<"line {} took {}">(i, 1.5); };
+
+    double synchronous = nanosecondsPerCall(lines, text);
+
+    // A ring large enough for the whole run: the logging thread never waits for the writer.
+    ThreadSafeIOStream::enableAsync(lines * 64);
+    double asyncText      = nanosecondsPerCall(lines, text);
+    double asyncTextDrain = syncMilliseconds();
+    double asyncLog       = nanosecondsPerCall(lines, deferred);
+    double asyncLogDrain  = syncMilliseconds();
+    ThreadSafeIOStream::disableAsync();
+
+    std::cout.rdbuf(stdoutBuffer);
+    std::printf("%-22s %12s %12s\n", "mode", "ns/line", "drain ms");
+    std::printf("%-22s %12.1f %12s\n", "synchronous <<", synchronous, "-");
+    std::printf("%-22s %12.1f %12.3f\n", "async <<", asyncText, asyncTextDrain);
+    std::printf("%-22s %12.1f %12.3f\n", "async log<>", asyncLog, asyncLogDrain);
+    return 0;
+}
@@ -0,0 +1,89 @@
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstddef>
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+#include <numeric>
+#include <random>
+#include <thread>
+#include <vector>
+
+#include "parallel.hpp"
+#include "worker_pool.hpp"
+
+template <typename TFunc>
+double measure(TFunc&& func)
+{
+    auto start = std::chrono::steady_clock::now();
+    func();
+    std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+    return elapsed.count();
+}
+
+void report(const char* name, size_t size, double serial, double parallel)
+{
+    std::printf(
+        "%-10s %12zu %12.3f %12.3f %8.2fx\n", name, size, serial, parallel, serial / parallel);
+}
+
+// Usage: parallel_bench [max_size] (default 100000000)
+int main(int argc, char** argv)
+{
+    size_t maxSize = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 100000000;
+    size_t threads = std::max(1u, std::thread::hardware_concurrency());
+
+    WorkerPool pool({.workerCount = std::max<size_t>(threads - 1, 1),
+                     .scheduling  = WorkerPool::Scheduling::WorkStealing});
+    std::printf("%zu workers + calling thread\n", pool.workerCount());
+    std::printf("%-10s %12s %12s %12s %9s\n",
+                "algorithm",
+                "size",
+                "serial ms",
+                "parallel ms",
+                "speedup");
+
+    std::mt19937 rng(1);
+    for (size_t size = 1000; size <= maxSize; size *= 10)
+    {
+        std::vector<float> in(size);
+        std::vector<float> out(size);
+        for (auto& v : in)
+            v = static_cast<float>(rng() % 10000);
+
+        auto heavy = [](float v) { return std::sqrt(v) * std::sin(v); };
+        auto body  = [&](size_t i) { out[i] = heavy(in[i]); };
+
+        report("for",
+               size,
+               measure(
+                   [&]
+                   {
+                       for (size_t i = 0; i < size; ++i)
+                           body(i);
+                   }),
+               measure([&] { parallel_for(pool, size_t(0), size, body); }));
+
+        volatile double sink;
+        std::plus<>     plus;
+        report("reduce",
+               size,
+               measure([&] { sink = std::accumulate(in.begin(), in.end(), 0.0); }),
+               measure([&] { sink = parallel_reduce(pool, in.begin(), in.end(), 0.0, plus); }));
+        (void)sink;
+
+        report("transform",
+               size,
+               measure([&] { std::transform(in.begin(), in.end(), out.begin(), heavy); }),
+               measure(
+                   [&] { parallel_transform(pool, in.begin(), in.end(), out.begin(), heavy); }));
+
+        std::vector<float> copy   = in;
+        double             serial = measure([&] { std::sort(copy.begin(), copy.end()); });
+        copy                      = in;
+        double parallel = measure([&] { parallel_sort(pool, copy.begin(), copy.end()); });
+        report("sort", size, serial, parallel);
+    }
+    return 0;
+}
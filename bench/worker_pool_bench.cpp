@@ -0,0 +1,109 @@
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdio>
+#include <thread>
+#include <vector>
+
+#include "worker_pool.hpp"
+
+// Fine-grained jobs laid out as an implicit binary tree: job i spawns jobs 2i+1 and 2i+2 from
+// inside execute(), like a recursive divide and conquer would.
+class TreeJob : public WorkerPool::IJob
+{
+public:
+    WorkerPool*           pool;
+    std::vector<TreeJob>* jobs;
+    std::atomic<size_t>*  done;
+    size_t                index;
+    volatile size_t       sink;
+
+    void execute() override
+    {
+        for (size_t child = 2 * index + 1; child <= 2 * index + 2; ++child)
+        {
+            if (child < jobs->size())
+                pool->addJob(&(*jobs)[child]);
+        }
+        size_t acc = index;
+        for (int i = 0; i < 64; ++i)
+            acc = acc * 31 + i;
+        sink = acc;
+        done->fetch_add(1, std::memory_order_release);
+    }
+};
+
+double run(WorkerPool::Scheduling scheduling, size_t threads, size_t jobCount, bool nested)
+{
+    std::vector<TreeJob> jobs(jobCount);
+    std::vector<TreeJob> none;
+    std::atomic<size_t>  done{0};
+
+    WorkerPool pool({.workerCount = threads, .scheduling = scheduling});
+    for (size_t i = 0; i < jobCount; ++i)
+    {
+        jobs[i].pool  = &pool;
+        jobs[i].jobs  = nested ? &jobs : &none;
+        jobs[i].done  = &done;
+        jobs[i].index = i;
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    if (nested)
+    {
+        pool.addJob(&jobs[0]);
+    }
+    else
+    {
+        for (auto& job : jobs)
+            pool.addJob(&job);
+    }
+    while (done.load(std::memory_order_acquire) != jobCount)
+        std::this_thread::yield();
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    return jobCount / elapsed.count() / 1e6;
+}
+
+// Round trip of one submit().get() on an otherwise idle pool, in microseconds.
+double roundTrip(WorkerPool::Scheduling scheduling, const WaitPolicy& policy)
+{
+    const int  rounds = 20000;
+    WorkerPool pool({.workerCount = 1, .scheduling = scheduling, .wait = policy});
+
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < rounds; ++i)
+        pool.submit([] {}).get();
+    std::chrono::duration<double, std::micro> elapsed = std::chrono::steady_clock::now() - start;
+    return elapsed.count() / rounds;
+}
+
+int main()
+{
+    const size_t hw   = std::max(1u, std::thread::hardware_concurrency());
+    const size_t jobs = 1 << 20;
+
+    std::printf("%-8s %-9s %14s %14s\n", "threads", "spawn", "shared Mjob/s", "stealing Mjob/s");
+    for (bool nested : {false, true})
+    {
+        for (size_t threads = 1; threads <= hw; threads *= 2)
+        {
+            std::printf("%-8zu %-9s %14.2f %14.2f\n",
+                        threads,
+                        nested ? "nested" : "external",
+                        run(WorkerPool::Scheduling::Shared, threads, jobs, nested),
+                        run(WorkerPool::Scheduling::WorkStealing, threads, jobs, nested));
+        }
+    }
+
+    std::printf("\n%-22s %10s %14s\n", "wait policy", "shared us", "stealing us");
+    for (WaitPolicy policy : {WaitPolicy{0, 0}, WaitPolicy{}})
+    {
+        std::printf("spins %-5u yields %-3u %10.2f %14.2f\n",
+                    policy.spins,
+                    policy.yields,
+                    roundTrip(WorkerPool::Scheduling::Shared, policy),
+                    roundTrip(WorkerPool::Scheduling::WorkStealing, policy));
+    }
+    return 0;
+}
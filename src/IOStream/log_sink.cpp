@@ -0,0 +1,366 @@
+#include "log_sink.hpp"
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <climits>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <mutex>
+#include <new>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <thread>
+#include <vector>
+
+namespace
+{
+size_t roundUp(size_t size, size_t multiple)
+{
+    return (size + multiple - 1) / multiple * multiple;
+}
+} // namespace
+
+void ConsoleSink::write(std::string_view text)
+{
+    std::cout.write(text.data(), static_cast<std::streamsize>(text.size()));
+    std::cout.flush();
+}
+
+FileSink::FileSink(const std::string& path) : FileSink(path, Options()) {}
+
+FileSink::FileSink(const std::string& path, const Options& options)
+    : _path(path), _options(options), _fd(-1), _direct(false), _offset(0), _current(nullptr),
+      _accepted(0), _written(0), _tailWritten(0), _syncTarget(0), _stop(false), _rotations(0),
+      _lastError(0)
+{
+    _options.bufferSize = roundUp(std::max(_options.bufferSize, BLOCK), BLOCK);
+    _options.buffers    = std::max<size_t>(_options.buffers, 2);
+    for (size_t i = 0; i < _options.buffers; ++i)
+    {
+        void* data = ::operator new(_options.bufferSize, std::align_val_t(BLOCK));
+        _buffers.push_back({static_cast<char*>(data), 0});
+    }
+    _current = &_buffers[0];
+    for (size_t i = 1; i < _buffers.size(); ++i)
+        _free.push_back(&_buffers[i]);
+
+    _direct   = _options.directIO;
+    int error = open();
+    if (error == EINVAL && _direct)
+    {
+        // tmpfs and a few others refuse O_DIRECT: keep going through the page cache.
+        _direct = false;
+        error   = open();
+    }
+    if (!error)
+        error = reloadTail();
+    if (error)
+    {
+        if (_fd >= 0)
+            ::close(_fd);
+        release();
+        throw std::system_error(error, std::generic_category(), "FileSink: " + path);
+    }
+    _thread = std::thread(&FileSink::run, this);
+}
+
+FileSink::~FileSink()
+{
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _stop = true;
+    }
+    _ready.notify_one();
+    _thread.join();
+    if (_fd >= 0)
+        ::close(_fd);
+    release();
+}
+
+void FileSink::write(std::string_view text)
+{
+    std::unique_lock<std::mutex> lock(_mutex);
+    _accepted += text.size();
+    while (!text.empty())
+    {
+        if (_current->size == _options.bufferSize)
+        {
+            _space.wait(lock, [&] { return !_free.empty(); });
+            seal(_current->size);
+            continue;
+        }
+        size_t count = std::min(text.size(), _options.bufferSize - _current->size);
+        std::memcpy(_current->data + _current->size, text.data(), count);
+        _current->size += count;
+        text.remove_prefix(count);
+    }
+}
+
+void FileSink::sync()
+{
+    std::unique_lock<std::mutex> lock(_mutex);
+    uint64_t                     target = _accepted;
+    _syncTarget                         = std::max(_syncTarget, target);
+    _ready.notify_one();
+    _synced.wait(lock, [&] { return _written >= target; });
+}
+
+const std::string& FileSink::path() const
+{
+    return _path;
+}
+
+bool FileSink::directIO() const
+{
+    return _direct;
+}
+
+uint64_t FileSink::rotations() const
+{
+    return _rotations.load();
+}
+
+int FileSink::lastError() const
+{
+    return _lastError.load();
+}
+
+int FileSink::open()
+{
+    _fd = ::open(_path.c_str(), O_RDWR | O_CREAT | O_CLOEXEC | (_direct ? O_DIRECT : 0), 0644);
+    if (_fd < 0)
+        return errno;
+
+    struct stat info;
+    if (::fstat(_fd, &info) != 0)
+    {
+        int error = errno;
+        ::close(_fd);
+        _fd = -1;
+        return error;
+    }
+    _offset = static_cast<uint64_t>(info.st_size);
+    _opened = std::chrono::steady_clock::now();
+    return 0;
+}
+
+int FileSink::reloadTail()
+{
+    // O_DIRECT writes whole blocks: reload the end of an existing file to rewrite it later.
+    size_t tail = _direct ? _offset % BLOCK : 0;
+    if (tail == 0)
+        return 0;
+    _offset -= tail;
+    if (::pread(_fd, _current->data, BLOCK, static_cast<off_t>(_offset))
+        != static_cast<ssize_t>(tail))
+        return errno ? errno : EIO;
+    _current->size = tail;
+    _tailWritten   = tail;
+    _written       = tail;
+    _accepted      = tail;
+    return 0;
+}
+
+void FileSink::release()
+{
+    for (Buffer& buffer : _buffers)
+        ::operator delete(buffer.data, std::align_val_t(BLOCK));
+    _buffers.clear();
+}
+
+void FileSink::run()
+{
+    std::unique_lock<std::mutex> lock(_mutex);
+    std::vector<Buffer*>         writing;
+    while (true)
+    {
+        bool woken    = _ready.wait_for(lock, _options.flushInterval, [&]
+                                     { return !_full.empty() || _stop || _syncTarget > _written; });
+        bool draining = !woken || _stop || _syncTarget > _written;
+
+        // Woken by a full buffer, leave the partial one to fill; otherwise write it too.
+        if (draining && !_free.empty())
+            seal(_direct ? _current->size / BLOCK * BLOCK : _current->size);
+
+        writing.assign(_full.begin(), _full.end());
+        _full.clear();
+        if (!writing.empty())
+        {
+            lock.unlock();
+            uint64_t bytes = writeBuffers(writing);
+            lock.lock();
+            _written += bytes;
+            for (Buffer* buffer : writing)
+            {
+                buffer->size = 0;
+                _free.push_back(buffer);
+            }
+            _space.notify_all();
+        }
+
+        bool settled = _full.empty() && _current->size < (_direct ? BLOCK : 1);
+        if (draining && settled && _direct && _current->size != _tailWritten)
+            writeTail();
+        if (rotationDue())
+            rotate(lock);
+        _synced.notify_all();
+
+        if (_stop && settled && _current->size == _tailWritten)
+            return;
+    }
+}
+
+void FileSink::seal(size_t length)
+{
+    if (length == 0)
+        return;
+
+    // The start of the buffer goes to _full; what is left after %length moves to a free one.
+    Buffer* next = _free.back();
+    _free.pop_back();
+    next->size = _current->size - length;
+    std::memcpy(next->data, _current->data + length, next->size);
+    _current->size = length;
+    _full.push_back(_current);
+    _current = next;
+
+    // The tail already in the file is rewritten with the block it belongs to.
+    _written -= _tailWritten;
+    _tailWritten = 0;
+    _ready.notify_one();
+}
+
+uint64_t FileSink::writeBuffers(const std::vector<Buffer*>& buffers)
+{
+    _iov.clear();
+    uint64_t total = 0;
+    for (Buffer* buffer : buffers)
+    {
+        _iov.push_back({buffer->data, buffer->size});
+        total += buffer->size;
+    }
+
+    iovec* iov    = _iov.data();
+    size_t count  = _iov.size();
+    size_t done   = 0;
+    bool   opened = reopen();
+    while (count > 0 && opened)
+    {
+        ssize_t result = ::pwritev(_fd, iov, static_cast<int>(std::min<size_t>(count, IOV_MAX)),
+                                   static_cast<off_t>(_offset + done));
+        if (result < 0)
+        {
+            if (errno == EINTR)
+                continue;
+            fail(errno);
+            break;
+        }
+        done += static_cast<size_t>(result);
+        for (size_t left = static_cast<size_t>(result); left > 0;)
+        {
+            size_t step = std::min(left, iov->iov_len);
+            iov->iov_base = static_cast<char*>(iov->iov_base) + step;
+            iov->iov_len -= step;
+            left -= step;
+            if (iov->iov_len == 0)
+            {
+                ++iov;
+                --count;
+            }
+        }
+    }
+    if (opened && _options.dataSync && ::fdatasync(_fd) != 0)
+        fail(errno);
+
+    // Whatever failed is dropped: the next buffers follow what reached the file, with no hole.
+    // O_DIRECT needs them on a block boundary; writeTail() cuts off what lies past the end.
+    if (done < total && _direct)
+        done = done / BLOCK * BLOCK;
+    _offset += done;
+    return total;
+}
+
+void FileSink::writeTail()
+{
+    // Pad the last block for O_DIRECT, then cut the file back to its real length.
+    size_t length = _current->size;
+    size_t padded = roundUp(length, BLOCK);
+    std::memset(_current->data + length, 0, padded - length);
+    if (reopen()
+        && (::pwrite(_fd, _current->data, padded, static_cast<off_t>(_offset)) < 0
+            || ::ftruncate(_fd, static_cast<off_t>(_offset + length)) != 0
+            || (_options.dataSync && ::fdatasync(_fd) != 0)))
+        fail(errno);
+    _written += length - _tailWritten;
+    _tailWritten = length;
+}
+
+bool FileSink::rotationDue() const
+{
+    uint64_t size = _offset + _tailWritten;
+    if (_options.maxFileSize && size >= _options.maxFileSize)
+        return true;
+    return _options.rotateInterval.count() > 0 && size > 0
+           && std::chrono::steady_clock::now() - _opened >= _options.rotateInterval;
+}
+
+void FileSink::rotate(std::unique_lock<std::mutex>& lock)
+{
+    // The tail already in the old file must not be written again to the new one.
+    if (_tailWritten)
+    {
+        _current->size -= _tailWritten;
+        std::memmove(_current->data, _current->data + _tailWritten, _current->size);
+        _tailWritten = 0;
+    }
+
+    // write() keeps filling buffers meanwhile.
+    lock.unlock();
+    if (_fd >= 0)
+        ::close(_fd);
+    for (size_t i = _options.keepFiles; i > 1; --i)
+        std::rename((_path + "." + std::to_string(i - 1)).c_str(),
+                    (_path + "." + std::to_string(i)).c_str());
+    if (_options.keepFiles)
+        std::rename(_path.c_str(), (_path + ".1").c_str());
+    else
+        ::unlink(_path.c_str());
+    if (int error = open())
+    {
+        // The old file is gone already: count from an empty one, so that the rotation is not
+        // due again at once, and let reopen() retry before the next write.
+        _offset = 0;
+        _opened = std::chrono::steady_clock::now();
+        fail(error);
+    }
+    lock.lock();
+    _rotations.fetch_add(1);
+}
+
+bool FileSink::reopen()
+{
+    if (_fd >= 0)
+        return true;
+    // A rotation could not open the new file: try again, without renaming anything.
+    if (int error = open())
+    {
+        fail(error);
+        return false;
+    }
+    return true;
+}
+
+void FileSink::fail(int error)
+{
+    _lastError.store(error);
+}
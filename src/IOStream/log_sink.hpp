@@ -0,0 +1,162 @@
+#ifndef _LOG_SINK_HPP
+#define _LOG_SINK_HPP
+
+#include <sys/uio.h>
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+/**
+ * @brief Destination of ThreadSafeIOStream output.
+ *
+ * write() receives whole lines, from one thread at a time. It runs on the thread that flushes,
+ * or on the background writer in async mode, so a sink that does slow I/O should hand the bytes
+ * to a thread of its own, as FileSink does.
+ */
+class LogSink
+{
+public:
+    virtual ~LogSink() = default;
+
+    /** %text is only valid during the call. */
+    virtual void write(std::string_view text) = 0;
+
+    /** Return once everything passed to write() so far is out of the sink's hands. */
+    virtual void sync() {}
+};
+
+/**
+ * @brief Writes to std::cout, as ThreadSafeIOStream does when no sink is installed.
+ */
+class ConsoleSink : public LogSink
+{
+public:
+    void write(std::string_view text) override;
+};
+
+/**
+ * @brief Appends to a file from a thread of its own, in large batches, with rotation.
+ *
+ * write() copies into 4 KiB aligned buffers; the sink's thread writes the full ones with a
+ * single pwritev, and the partial one when flushInterval elapses. Rotation renames the files on
+ * that thread too, so whoever logs never waits for the disk unless every buffer is full. Each
+ * FileSink has its own thread: several sinks write in parallel.
+ */
+class FileSink : public LogSink
+{
+public:
+    static constexpr size_t BLOCK = 4096;
+
+    struct Options
+    {
+        /** Size of each buffer, rounded up to a multiple of BLOCK. */
+        size_t bufferSize = 1 << 20;
+        /** Buffers filled while the previous ones are written; write() waits when all are. */
+        size_t buffers = 4;
+        /** Longest time a partial buffer waits before being written. */
+        std::chrono::milliseconds flushInterval{100};
+
+        /** Rotate once the file reaches this size; 0 never does. */
+        size_t maxFileSize = 0;
+        /** Rotate when the file is this old and not empty; 0 never does. */
+        std::chrono::milliseconds rotateInterval{0};
+        /** Rotated files kept as path.1 (newest) to path.N. */
+        size_t keepFiles = 5;
+
+        /** Bypass the page cache with O_DIRECT where the file system allows it. */
+        bool directIO = false;
+        /** fdatasync after every write, so what was written survives a crash. */
+        bool dataSync = false;
+    };
+
+    /**
+     * @throw std::system_error if the file cannot be opened.
+     */
+    explicit FileSink(const std::string& path);
+    FileSink(const std::string& path, const Options& options);
+
+    /**
+     * @brief Writes out what is buffered and closes the file.
+     */
+    ~FileSink() override;
+
+    FileSink(const FileSink&)            = delete;
+    FileSink& operator=(const FileSink&) = delete;
+
+    void write(std::string_view text) override;
+
+    /**
+     * @brief Wait until everything written so far is in the file (and on disk with dataSync).
+     */
+    void sync() override;
+
+    const std::string& path() const;
+    /** Whether O_DIRECT is in use: false when not requested or refused by the file system. */
+    bool     directIO() const;
+    uint64_t rotations() const;
+    /**
+     * @brief errno of the last failed write or rotation, 0 if none.
+     *
+     * The data involved is dropped and what follows is written right after what reached the
+     * file. When a rotation cannot open the new file, each later write tries again.
+     */
+    int lastError() const;
+
+private:
+    struct Buffer
+    {
+        char*  data;
+        size_t size;
+    };
+
+    std::string                           _path;
+    Options                               _options;
+    int                                   _fd;
+    bool                                  _direct;
+    // Bytes of the current file written up to a BLOCK boundary; with O_DIRECT, the unaligned
+    // tail stays in the current buffer and is rewritten from here.
+    uint64_t                              _offset;
+    std::chrono::steady_clock::time_point _opened;
+
+    std::vector<Buffer>     _buffers;
+    Buffer*                 _current;
+    std::vector<Buffer*>    _free;
+    std::deque<Buffer*>     _full;
+    std::vector<iovec>      _iov;
+    std::mutex              _mutex;
+    std::condition_variable _ready;
+    std::condition_variable _space;
+    std::condition_variable _synced;
+    // Bytes handed to write(), and of those, bytes in the file.
+    uint64_t                _accepted;
+    uint64_t                _written;
+    size_t                  _tailWritten;
+    uint64_t                _syncTarget;
+    bool                    _stop;
+    std::atomic<uint64_t>   _rotations;
+    std::atomic<int>        _lastError;
+    std::thread             _thread;
+
+    int      open();
+    int      reloadTail();
+    void     release();
+    void     run();
+    void     seal(size_t length);
+    uint64_t writeBuffers(const std::vector<Buffer*>& buffers);
+    void     writeTail();
+    bool     rotationDue() const;
+    void     rotate(std::unique_lock<std::mutex>& lock);
+    bool     reopen();
+    void     fail(int error);
+};
+
+#endif // !_LOG_SINK_HPP
@@ -1,14 +1,357 @@
 #include "thread_safe_iostream.hpp"
 
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
 #include <mutex>
 #include <ostream>
+#include <semaphore>
 #include <sstream>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <utility>
+#include <vector>
 
-std::mutex ThreadSafeIOStream::_global_io_mutex;
+#include "log_sink.hpp"
+
+std::mutex                            ThreadSafeIOStream::_global_io_mutex;
+std::vector<std::shared_ptr<LogSink>> ThreadSafeIOStream::_sinks;
+
+/**
+ * Single-producer single-consumer ring of frames: the owning thread appends at tail, the writer
+ * reads from head. Positions only grow; masking gives the offset. A frame is a header and its
+ * payload, padded to FRAME_ALIGN, and never wraps: one that does not fit before the end of the
+ * ring is preceded by a padding frame.
+ */
+struct ThreadSafeIOStream::Ring
+{
+    explicit Ring(size_t capacity) : data(new char[capacity]), capacity(capacity) {}
+
+    std::unique_ptr<char[]> data;
+    size_t                  capacity;
+    alignas(64) std::atomic<size_t> head{0};
+    alignas(64) std::atomic<size_t> tail{0};
+    // What reached the sinks, for sync().
+    std::atomic<size_t> written{0};
+    std::atomic<bool>   closed{false};
+    // Owner side: size of the frame between beginRecord() and commitRecord().
+    size_t reserved = 0;
+    // Writer side: prefix of the deferred records.
+    std::string prefix;
+};
+
+class ThreadSafeIOStream::Writer
+{
+public:
+    enum class Kind : uint32_t
+    {
+        Text,
+        Prefix,
+        Record,
+        Padding,
+    };
+
+    ~Writer()
+    {
+        stop();
+    }
+
+    bool enabled() const
+    {
+        return _enabled.load(std::memory_order_acquire);
+    }
+
+    void start(size_t ringSize)
+    {
+        std::lock_guard<std::mutex> control(_control);
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            _ringSize = std::bit_ceil(std::max<size_t>(ringSize, 256));
+        }
+        if (enabled())
+            return;
+        _stop.store(false);
+        _thread = std::thread(&Writer::run, this);
+        _enabled.store(true, std::memory_order_release);
+    }
+
+    void stop()
+    {
+        std::lock_guard<std::mutex> control(_control);
+        if (!enabled())
+            return;
+        _enabled.store(false, std::memory_order_release);
+        _stop.store(true);
+        wake();
+        _thread.join();
+    }
+
+    std::shared_ptr<Ring> attach()
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _rings.push_back(std::make_shared<Ring>(_ringSize));
+        return _rings.back();
+    }
+
+    static size_t maxPayload(const Ring& ring)
+    {
+        return ring.capacity - sizeof(Header);
+    }
+
+    /**
+     * Wait for room for a frame of %size payload bytes, write its header and return where the
+     * payload goes. The frame is published by commit().
+     */
+    char* reserve(Ring& ring, Kind kind, Decoder decode, size_t size)
+    {
+        size_t frame = sizeof(Header) + roundUp(size);
+        while (true)
+        {
+            size_t tail   = ring.tail.load(std::memory_order_relaxed);
+            size_t space  = ring.capacity - (tail - ring.head.load(std::memory_order_acquire));
+            size_t offset = tail & (ring.capacity - 1);
+            size_t end    = ring.capacity - offset;
+            if (frame <= end && frame <= space)
+            {
+                writeHeader(ring.data.get() + offset, Header{kind, uint32_t(size), decode});
+                ring.reserved = frame;
+                return ring.data.get() + offset + sizeof(Header);
+            }
+            if (frame > end && end <= space)
+            {
+                writeHeader(ring.data.get() + offset,
+                            Header{Kind::Padding, uint32_t(end - sizeof(Header)), nullptr});
+                ring.tail.store(tail + end);
+                continue;
+            }
+            // The writer is behind: wait for it rather than drop the line.
+            wake();
+            std::this_thread::yield();
+        }
+    }
+
+    void commit(Ring& ring)
+    {
+        ring.tail.store(ring.tail.load(std::memory_order_relaxed) + ring.reserved);
+        // Checking first keeps the read-modify-write off the path where the writer is awake.
+        if (_sleeping.load())
+            wake();
+    }
+
+    // Text that fits in the ring stays in one frame, so the writer never cuts a line.
+    void push(Ring& ring, Kind kind, std::string_view text)
+    {
+        do
+        {
+            size_t count = std::min(text.size(), maxPayload(ring));
+            std::memcpy(reserve(ring, kind, nullptr, count), text.data(), count);
+            commit(ring);
+            text.remove_prefix(count);
+        } while (!text.empty());
+    }
+
+    void sync()
+    {
+        if (!enabled())
+            return;
+
+        std::unique_lock<std::mutex>                          lock(_mutex);
+        std::vector<std::pair<std::shared_ptr<Ring>, size_t>> targets;
+        for (const std::shared_ptr<Ring>& ring : _rings)
+            targets.emplace_back(ring, ring->tail.load());
+        wake();
+        _written.wait(lock,
+                      [&]
+                      {
+                          return std::all_of(targets.begin(), targets.end(),
+                                             [](const auto& target)
+                                             { return target.first->written >= target.second; });
+                      });
+    }
+
+private:
+    struct Header
+    {
+        Kind     kind;
+        uint32_t size;
+        Decoder  decode;
+    };
+
+    static constexpr size_t FRAME_ALIGN = 16;
+    static_assert(sizeof(Header) % FRAME_ALIGN == 0);
+
+    std::atomic<bool>                     _enabled{false};
+    std::atomic<bool>                     _stop{false};
+    std::atomic<bool>                     _sleeping{false};
+    std::binary_semaphore                 _wakeup{0};
+    std::thread                           _thread;
+    std::mutex                            _control;
+    std::mutex                            _mutex;
+    std::condition_variable               _written;
+    std::vector<std::shared_ptr<Ring>>    _rings;
+    std::vector<std::pair<Ring*, size_t>> _taken;
+    std::string                           _line;
+    size_t                                _ringSize = 0;
+
+    static size_t roundUp(size_t size)
+    {
+        return (size + FRAME_ALIGN - 1) & ~(FRAME_ALIGN - 1);
+    }
+
+    static void writeHeader(char* at, const Header& header)
+    {
+        std::memcpy(at, &header, sizeof(header));
+    }
+
+    void wake()
+    {
+        // Whoever clears the flag owes the writer exactly one release.
+        if (_sleeping.exchange(false))
+            _wakeup.release();
+    }
+
+    void run()
+    {
+        std::string batch;
+        while (true)
+        {
+            bool stopping = _stop.load();
+            if (drain(batch))
+                continue;
+            if (stopping)
+                return;
+
+            _sleeping.store(true);
+            if (pending() || _stop.load())
+            {
+                if (!_sleeping.exchange(false))
+                    _wakeup.acquire();
+                continue;
+            }
+            _wakeup.acquire();
+        }
+    }
+
+    bool pending()
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        return std::any_of(_rings.begin(), _rings.end(),
+                           [](const std::shared_ptr<Ring>& ring)
+                           { return ring->tail.load() != ring->head.load(); });
+    }
+
+    // Line starts of a deferred record get the prefix its thread had when it was logged.
+    static void appendPrefixed(std::string& batch, const std::string& prefix,
+                               std::string_view text)
+    {
+        while (!text.empty())
+        {
+            const void* newline = std::memchr(text.data(), '\n', text.size());
+            size_t      length  = newline ? static_cast<const char*>(newline) - text.data() + 1
+                                          : text.size();
+            batch += prefix;
+            batch.append(text.data(), length);
+            text.remove_prefix(length);
+        }
+    }
+
+    void read(Ring& ring, size_t head, size_t tail, std::string& batch)
+    {
+        while (head != tail)
+        {
+            const char* frame = ring.data.get() + (head & (ring.capacity - 1));
+            Header      header;
+            std::memcpy(&header, frame, sizeof(header));
+            std::string_view payload(frame + sizeof(Header), header.size);
+            switch (header.kind)
+            {
+            case Kind::Text:
+                batch += payload;
+                break;
+            case Kind::Prefix:
+                ring.prefix.assign(payload);
+                break;
+            case Kind::Record:
+                _line.clear();
+                header.decode(payload, _line);
+                _line += '\n';
+                appendPrefixed(batch, ring.prefix, _line);
+                break;
+            case Kind::Padding:
+                break;
+            }
+            head += sizeof(Header) + roundUp(header.size);
+        }
+    }
+
+    // Turn every ring into one batch and write it with a single flush.
+    bool drain(std::string& batch)
+    {
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            std::erase_if(_rings,
+                          [](const std::shared_ptr<Ring>& ring)
+                          {
+                              return ring->closed.load(std::memory_order_acquire)
+                                     && ring->written.load() == ring->tail.load();
+                          });
+            for (const std::shared_ptr<Ring>& ring : _rings)
+            {
+                size_t head = ring->head.load(std::memory_order_relaxed);
+                size_t tail = ring->tail.load(std::memory_order_acquire);
+                if (head == tail)
+                    continue;
+                read(*ring, head, tail, batch);
+                ring->head.store(tail, std::memory_order_release);
+                _taken.emplace_back(ring.get(), tail);
+            }
+        }
+        if (_taken.empty())
+            return false;
+
+        if (!batch.empty())
+        {
+            std::lock_guard<std::mutex> lock(_global_io_mutex);
+            emit(batch);
+        }
+        batch.clear();
+
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            for (const auto& [ring, end] : _taken)
+                ring->written.store(end);
+            _taken.clear();
+        }
+        _written.notify_all();
+        return true;
+    }
+};
+
+ThreadSafeIOStream::~ThreadSafeIOStream()
+{
+    if (_ring)
+    {
+        flush();
+        _ring->closed.store(true, std::memory_order_release);
+    }
+}
+
+ThreadSafeIOStream::Writer& ThreadSafeIOStream::writer()
+{
+    static Writer writer;
+    return writer;
+}
 
 void ThreadSafeIOStream::setPrefix(const std::string& prefix)
 {
-    _prefix = prefix;
+    _prefix     = prefix;
+    _prefixSent = false;
 }
 
 ThreadSafeIOStream& ThreadSafeIOStream::operator<<(std::ostream& (*manip)(std::ostream&))
@@ -16,31 +359,142 @@ ThreadSafeIOStream& ThreadSafeIOStream::operator<<(std::ostream& (*manip)(std::o
 
     if (manip == static_cast<std::ostream& (*)(std::ostream&)>(std::endl))
     {
-        _buffer << '\n';
+        append("\n");
         flush();
     }
     else
     {
-        manip(_buffer);
+        std::ostringstream ss;
+        manip(ss);
+        append(ss.view());
     }
     return *this;
 }
 
+void ThreadSafeIOStream::append(std::string_view text)
+{
+    while (!text.empty())
+    {
+        if (_atEndLine)
+        {
+            _buffer += _prefix;
+            _atEndLine = false;
+        }
+
+        const void* newline = std::memchr(text.data(), '\n', text.size());
+        if (!newline)
+        {
+            _buffer += text;
+            return;
+        }
+        size_t length = static_cast<const char*>(newline) - text.data() + 1;
+        _buffer.append(text.data(), length);
+        _atEndLine = true;
+        text.remove_prefix(length);
+    }
+}
+
 void ThreadSafeIOStream::flush()
 {
-    auto temp = _buffer.str();
-    _buffer.str("");
-    _buffer.clear();
     _atEndLine = true;
+    if (_buffer.empty())
+    {
+        return;
+    }
 
-    if (temp.empty())
+    // clear() keeps the capacity, so the buffer stops allocating once it fits a flush.
+    Writer& async = writer();
+    if (async.enabled())
     {
+        if (!_ring)
+            _ring = async.attach();
+        async.push(*_ring, Writer::Kind::Text, _buffer);
+        _buffer.clear();
         return;
     }
 
     std::lock_guard<std::mutex> lock(_global_io_mutex);
-    std::cout << temp;
-    std::cout.flush();
+    emit(_buffer);
+    _buffer.clear();
+}
+
+char* ThreadSafeIOStream::beginRecord(Decoder decode, size_t size)
+{
+    Writer& async = writer();
+    if (!async.enabled())
+        return nullptr;
+
+    flush();
+    if (!_ring)
+        _ring = async.attach();
+    if (size > Writer::maxPayload(*_ring))
+        return nullptr;
+    if (!_prefixSent)
+    {
+        async.push(*_ring, Writer::Kind::Prefix, _prefix);
+        _prefixSent = true;
+    }
+    return async.reserve(*_ring, Writer::Kind::Record, decode, size);
+}
+
+void ThreadSafeIOStream::commitRecord()
+{
+    writer().commit(*_ring);
+}
+
+void ThreadSafeIOStream::emit(std::string_view text)
+{
+    if (_sinks.empty())
+    {
+        std::cout.write(text.data(), static_cast<std::streamsize>(text.size()));
+        std::cout.flush();
+        return;
+    }
+    for (const std::shared_ptr<LogSink>& sink : _sinks)
+        sink->write(text);
+}
+
+void ThreadSafeIOStream::addSink(std::shared_ptr<LogSink> sink)
+{
+    std::lock_guard<std::mutex> lock(_global_io_mutex);
+    _sinks.push_back(std::move(sink));
+}
+
+void ThreadSafeIOStream::clearSinks()
+{
+    sync();
+    std::vector<std::shared_ptr<LogSink>> removed;
+    {
+        std::lock_guard<std::mutex> lock(_global_io_mutex);
+        removed.swap(_sinks);
+    }
+}
+
+void ThreadSafeIOStream::enableAsync(size_t ringSize)
+{
+    writer().start(ringSize);
+}
+
+void ThreadSafeIOStream::disableAsync()
+{
+    writer().stop();
+}
+
+bool ThreadSafeIOStream::async()
+{
+    return writer().enabled();
+}
+
+void ThreadSafeIOStream::sync()
+{
+    writer().sync();
+    std::vector<std::shared_ptr<LogSink>> sinks;
+    {
+        std::lock_guard<std::mutex> lock(_global_io_mutex);
+        sinks = _sinks;
+    }
+    for (const std::shared_ptr<LogSink>& sink : sinks)
+        sink->sync();
 }
 
 thread_local ThreadSafeIOStream ThreadSafeIO;
@@ -3,54 +3,168 @@
 
 #include <cstddef>
 #include <iostream>
+#include <memory>
 #include <mutex>
 #include <ostream>
 #include <sstream>
 #include <string>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+#include <vector>
+#include <version>
+#if defined(__cpp_lib_format)
+#include <format>
+#include <iterator>
+#endif
 
+#include "log_sink.hpp"
+
+/**
+ * @brief Format string of ThreadSafeIOStream::log(), known at compile time: text with one "{}"
+ * per argument.
+ */
+template <size_t N>
+struct FormatString
+{
+    char text[N] = {};
+
+    consteval FormatString(const char (&literal)[N])
+    {
+        for (size_t i = 0; i < N; ++i)
+            text[i] = literal[i];
+    }
+
+    constexpr std::string_view view() const
+    {
+        return std::string_view(text, N - 1);
+    }
+
+    constexpr size_t placeholders() const
+    {
+        // A plain loop: string_view::find is not a constant expression everywhere.
+        size_t count = 0;
+        for (size_t i = 0; i + 2 < N; ++i)
+        {
+            if (text[i] == '{' && text[i + 1] == '}')
+            {
+                ++count;
+                ++i;
+            }
+        }
+        return count;
+    }
+};
+
+/**
+ * @brief Per-thread output stream whose lines never interleave.
+ *
+ * By default flush() writes to std::cout under a global mutex; addSink() sends the lines
+ * elsewhere, to files for instance. In async mode it only copies the text into a ring owned by
+ * the thread and a background writer hands the rings to the output in batches, so logging
+ * threads neither wait on each other nor on the terminal. Lines of one thread keep their order;
+ * lines of different threads may come out in another order than they were flushed.
+ */
 class ThreadSafeIOStream
 {
 private:
-    std::string        _prefix = "";
-    std::ostringstream _buffer;
-    bool               _atEndLine = true;
+    struct Ring;
+    class Writer;
+
+    std::string           _prefix = "";
+    std::string           _buffer;
+    std::string           _scratch;
+    bool                  _atEndLine = true;
+    std::shared_ptr<Ring> _ring;
+    std::string           _record;
+    bool                  _prefixSent = false;
 
     static std::mutex _global_io_mutex;
+    // Guarded by _global_io_mutex; std::cout when empty.
+    static std::vector<std::shared_ptr<LogSink>> _sinks;
+
+    static Writer& writer();
+    /** Hand finished lines to the sinks; _global_io_mutex must be held. */
+    static void emit(std::string_view text);
+
+    void append(std::string_view text);
+
+    template <typename T>
+    static void formatValue(std::string& out, const T& value);
+
+    // Deferred records: the decoder of the call site, then the raw bytes of its arguments.
+    using Decoder = void (*)(std::string_view payload, std::string& out);
+
+    template <typename T>
+    static constexpr bool isText = std::is_convertible_v<const T&, std::string_view>;
+
+    /** Space for a record in the thread's ring, or null when it has to be formatted here. */
+    char* beginRecord(Decoder decode, size_t size);
+    void  commitRecord();
+
+    template <typename T>
+    static size_t encodedSize(const T& value);
+    template <typename T>
+    static void encode(char*& out, const T& value);
+    template <typename T>
+    static void decodeValue(const char*& in, std::string& out);
+    template <FormatString Format, typename... TStored>
+    static void decodeRecord(std::string_view payload, std::string& out);
 
 public:
+    ThreadSafeIOStream() = default;
+    /** In async mode, hands over what is left in the buffer. */
+    ~ThreadSafeIOStream();
+
+    /**
+     * @brief Append %value as std::ostream would format it, with the prefix at each line start.
+     *
+     * Numbers go through std::to_chars and strings are appended as they are, straight into the
+     * stream's buffer, which keeps its capacity between lines: once warm, logging them does
+     * not allocate. Other types still use a temporary std::ostringstream.
+     */
     template <typename T>
     ThreadSafeIOStream& operator<<(const T& value)
     {
-        std::ostringstream ss;
-        ss << value;
-        std::string tmp = ss.str();
-
-        size_t start = 0;
-        while (start < tmp.size())
+        if constexpr (std::is_convertible_v<const T&, std::string_view>)
+            append(std::string_view(value));
+        else
         {
-            if (_atEndLine)
-            {
-                _buffer << _prefix;
-                _atEndLine = false;
-            }
-
-            size_t pos = tmp.find('\n', start);
-            if (pos == std::string::npos)
-            {
-                _buffer << std::string(tmp.begin() + start, tmp.end());
-                break;
-            }
-            std::string line(tmp.begin() + start, tmp.begin() + pos + 1);
-            _buffer << line;
-            _atEndLine = true;
-            start      = pos + 1;
+            _scratch.clear();
+            formatValue(_scratch, value);
+            append(_scratch);
         }
+        return *this;
+    }
 
+#if defined(__cpp_lib_format)
+    /**
+     * @brief std::format into the stream's buffer, with the prefix at each line start.
+     */
+    template <typename... TArgs>
+    ThreadSafeIOStream& format(std::format_string<TArgs...> fmt, TArgs&&... args)
+    {
+        _scratch.clear();
+        std::format_to(std::back_inserter(_scratch), fmt, std::forward<TArgs>(args)...);
+        append(_scratch);
         return *this;
     }
+#endif
 
     ThreadSafeIOStream& operator<<(std::ostream& (*manip)(std::ostream&));
 
+    /**
+     * @brief Log one line, formatted later by the background writer.
+     *
+     * `ThreadSafeIO.log<"{} jobs in {} us">(jobs, elapsed);` only copies the arguments and a
+     * pointer to the code that formats them into the thread's ring, so the calling thread pays
+     * for a few stores rather than for the formatting. Arguments are numbers, characters and
+     * strings, formatted as operator<< does; strings are copied. Outside async mode, or for a
+     * line larger than the ring, the line is formatted and flushed right away.
+     */
+    template <FormatString Format, typename... TArgs>
+    void log(const TArgs&... args);
+
     template <typename T>
     ThreadSafeIOStream& operator>>(T& value)
     {
@@ -64,6 +178,7 @@ public:
     template <typename T>
     void prompt(const std::string& question, T& dest)
     {
+        sync();
         {
             std::lock_guard<std::mutex> lock(_global_io_mutex);
             std::cout << _prefix << question;
@@ -74,8 +189,42 @@ public:
     }
 
     void flush();
+
+    /**
+     * @brief Start the background writer.
+     * @param ringSize Bytes of each thread's ring, rounded up to a power of two. A thread whose
+     * ring is full waits for the writer rather than losing lines; a flush larger than the ring
+     * goes in pieces, which lines of other threads may come between.
+     */
+    static void enableAsync(size_t ringSize = 64 * 1024);
+
+    /**
+     * @brief Write out everything flushed so far, then go back to synchronous writes.
+     * @warning No thread may be flushing meanwhile.
+     */
+    static void disableAsync();
+
+    static bool async();
+
+    /**
+     * @brief Wait until every line flushed so far, by any thread, went through every sink.
+     */
+    static void sync();
+
+    /**
+     * @brief Send the output to %sink. With sinks installed std::cout gets nothing, unless one
+     * of them is a ConsoleSink.
+     */
+    static void addSink(std::shared_ptr<LogSink> sink);
+
+    /**
+     * @brief Sync, then go back to std::cout.
+     */
+    static void clearSinks();
 };
 
 extern thread_local ThreadSafeIOStream ThreadSafeIO;
 
+#include "thread_safe_iostream.tpp"
+
 #endif // !_THREAD_SAFE_IOSTREAM_HPP
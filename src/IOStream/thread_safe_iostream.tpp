@@ -0,0 +1,142 @@
+#ifndef _THREAD_SAFE_IOSTREAM_TPP
+#define _THREAD_SAFE_IOSTREAM_TPP
+
+#include <charconv>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <type_traits>
+
+#include "thread_safe_iostream.hpp"
+
+template <typename T>
+void ThreadSafeIOStream::formatValue(std::string& out, const T& value)
+{
+    constexpr bool character = std::is_same_v<T, char> || std::is_same_v<T, signed char>
+                               || std::is_same_v<T, unsigned char>;
+    if constexpr (character)
+        out += static_cast<char>(value);
+    else if constexpr (std::is_same_v<T, bool>)
+        out += value ? '1' : '0';
+    else if constexpr (std::is_arithmetic_v<T>)
+    {
+        char                 digits[64];
+        std::to_chars_result result;
+        if constexpr (std::is_floating_point_v<T>)
+            result = std::to_chars(digits, digits + sizeof(digits), value,
+                                   std::chars_format::general, 6); // std::ostream's default
+        else
+            result = std::to_chars(digits, digits + sizeof(digits), value);
+        out.append(digits, result.ptr);
+    }
+    else if constexpr (isText<T>)
+        out += std::string_view(value);
+    else
+    {
+        std::ostringstream ss;
+        ss << value;
+        out += ss.view();
+    }
+}
+
+template <typename T>
+size_t ThreadSafeIOStream::encodedSize(const T& value)
+{
+    if constexpr (isText<T>)
+        return sizeof(uint32_t) + std::string_view(value).size();
+    else
+        return sizeof(T);
+}
+
+template <typename T>
+void ThreadSafeIOStream::encode(char*& out, const T& value)
+{
+    if constexpr (isText<T>)
+    {
+        std::string_view text(value);
+        uint32_t         size = static_cast<uint32_t>(text.size());
+        std::memcpy(out, &size, sizeof(size));
+        std::memcpy(out + sizeof(size), text.data(), size);
+        out += sizeof(size) + size;
+    }
+    else
+    {
+        std::memcpy(out, &value, sizeof(T));
+        out += sizeof(T);
+    }
+}
+
+template <typename T>
+void ThreadSafeIOStream::decodeValue(const char*& in, std::string& out)
+{
+    if constexpr (std::is_same_v<T, std::string_view>)
+    {
+        uint32_t size;
+        std::memcpy(&size, in, sizeof(size));
+        out.append(in + sizeof(size), size);
+        in += sizeof(size) + size;
+    }
+    else
+    {
+        T value;
+        std::memcpy(&value, in, sizeof(T));
+        formatValue(out, value);
+        in += sizeof(T);
+    }
+}
+
+template <FormatString Format, typename... TStored>
+void ThreadSafeIOStream::decodeRecord(std::string_view payload, std::string& out)
+{
+    std::string_view             format = Format.view();
+    [[maybe_unused]] const char* in     = payload.data();
+    (
+        [&]
+        {
+            size_t at = format.find("{}");
+            out += format.substr(0, at);
+            format.remove_prefix(at + 2);
+            decodeValue<TStored>(in, out);
+        }(),
+        ...);
+    out += format;
+}
+
+template <FormatString Format, typename... TArgs>
+void ThreadSafeIOStream::log(const TArgs&... args)
+{
+    static_assert(Format.placeholders() == sizeof...(TArgs),
+                  "log: one argument per {} in the format string");
+    static_assert(((std::is_arithmetic_v<TArgs> || isText<TArgs>) && ...),
+                  "log: arguments are numbers, characters or strings");
+
+    // The decoder's address is what identifies the call site in the ring.
+    constexpr Decoder decode = &decodeRecord<
+        Format, std::conditional_t<isText<TArgs>, std::string_view, TArgs>...>;
+    size_t size     = (encodedSize(args) + ... + size_t(0));
+    char*  out      = beginRecord(decode, size);
+    bool   deferred = out != nullptr;
+    if (!deferred)
+    {
+        _record.resize(size);
+        out = _record.data();
+    }
+    (encode(out, args), ...);
+    if (deferred)
+    {
+        commitRecord();
+        return;
+    }
+
+    flush();
+    _scratch.clear();
+    decode(_record, _scratch);
+    _scratch += '\n';
+    append(_scratch);
+    flush();
+}
+
+#endif // !_THREAD_SAFE_IOSTREAM_TPP
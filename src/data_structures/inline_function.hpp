@@ -0,0 +1,168 @@
+#ifndef _INLINE_FUNCTION_HPP
+#define _INLINE_FUNCTION_HPP
+
+#include <cstddef>
+#include <functional>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+template <typename TSignature, size_t TCapacity = 48>
+class InlineFunction;
+
+/**
+ * @brief Move-only type-erased callable with small buffer optimization.
+ *
+ * Callables up to TCapacity bytes (and nothrow movable) are stored inline, so wrapping a small
+ * lambda never allocates. Bigger ones fall back to the heap. Unlike std::function, the wrapped
+ * callable does not need to be copyable.
+ */
+template <typename TResult, typename... TArgs, size_t TCapacity>
+class InlineFunction<TResult(TArgs...), TCapacity>
+{
+private:
+    struct VTable
+    {
+        TResult (*invoke)(void* storage, TArgs&&... args);
+        void (*move)(void* dest, void* src) noexcept;
+        void (*destroy)(void* storage) noexcept;
+    };
+
+    template <typename TFunc>
+    struct Inline
+    {
+        static TFunc* get(void* storage)
+        {
+            return std::launder(reinterpret_cast<TFunc*>(storage));
+        }
+        static TResult invoke(void* storage, TArgs&&... args)
+        {
+            return std::invoke(*get(storage), std::forward<TArgs>(args)...);
+        }
+        static void move(void* dest, void* src) noexcept
+        {
+            new (dest) TFunc(std::move(*get(src)));
+            get(src)->~TFunc();
+        }
+        static void destroy(void* storage) noexcept
+        {
+            get(storage)->~TFunc();
+        }
+        static constexpr VTable vtable = {&invoke, &move, &destroy};
+    };
+
+    template <typename TFunc>
+    struct Heap
+    {
+        static TFunc*& get(void* storage)
+        {
+            return *std::launder(reinterpret_cast<TFunc**>(storage));
+        }
+        static TResult invoke(void* storage, TArgs&&... args)
+        {
+            return std::invoke(*get(storage), std::forward<TArgs>(args)...);
+        }
+        static void move(void* dest, void* src) noexcept
+        {
+            new (dest) TFunc*(get(src));
+        }
+        static void destroy(void* storage) noexcept
+        {
+            delete get(storage);
+        }
+        static constexpr VTable vtable = {&invoke, &move, &destroy};
+    };
+
+    alignas(std::max_align_t) unsigned char _storage[TCapacity];
+    const VTable* _vtable = nullptr;
+
+    void reset() noexcept
+    {
+        if (_vtable)
+            _vtable->destroy(_storage);
+        _vtable = nullptr;
+    }
+
+public:
+    /**
+     * @brief Tell whether a callable of type TFunc is stored without allocating.
+     */
+    template <typename TFunc>
+    static constexpr bool storesInline = sizeof(TFunc) <= TCapacity &&
+                                         alignof(TFunc) <= alignof(std::max_align_t) &&
+                                         std::is_nothrow_move_constructible_v<TFunc>;
+
+    InlineFunction() noexcept = default;
+    InlineFunction(std::nullptr_t) noexcept {}
+
+    template <typename TFunc,
+              typename = std::enable_if_t<!std::is_same_v<std::decay_t<TFunc>, InlineFunction>>>
+    InlineFunction(TFunc&& func)
+    {
+        using TStored = std::decay_t<TFunc>;
+        static_assert(std::is_invocable_r_v<TResult, TStored&, TArgs...>,
+                      "InlineFunction: callable does not match the signature");
+
+        if constexpr (storesInline<TStored>)
+        {
+            new (_storage) TStored(std::forward<TFunc>(func));
+            _vtable = &Inline<TStored>::vtable;
+        }
+        else
+        {
+            new (_storage) TStored*(new TStored(std::forward<TFunc>(func)));
+            _vtable = &Heap<TStored>::vtable;
+        }
+    }
+
+    InlineFunction(InlineFunction&& other) noexcept : _vtable(other._vtable)
+    {
+        if (_vtable)
+            _vtable->move(_storage, other._storage);
+        other._vtable = nullptr;
+    }
+
+    InlineFunction& operator=(InlineFunction&& other) noexcept
+    {
+        if (this != &other)
+        {
+            reset();
+            _vtable = other._vtable;
+            if (_vtable)
+                _vtable->move(_storage, other._storage);
+            other._vtable = nullptr;
+        }
+        return *this;
+    }
+
+    InlineFunction& operator=(std::nullptr_t) noexcept
+    {
+        reset();
+        return *this;
+    }
+
+    InlineFunction(const InlineFunction&)            = delete;
+    InlineFunction& operator=(const InlineFunction&) = delete;
+
+    ~InlineFunction()
+    {
+        reset();
+    }
+
+    explicit operator bool() const noexcept
+    {
+        return _vtable != nullptr;
+    }
+
+    /**
+     * @throw std::bad_function_call if empty.
+     */
+    TResult operator()(TArgs... args)
+    {
+        if (!_vtable)
+            throw std::bad_function_call();
+        return _vtable->invoke(_storage, std::forward<TArgs>(args)...);
+    }
+};
+
+#endif // !_INLINE_FUNCTION_HPP
@@ -0,0 +1,63 @@
+#ifndef _RING_BUFFER_HPP
+#define _RING_BUFFER_HPP
+
+#include <cstddef>
+#include <utility>
+#include <vector>
+
+/**
+ * @brief Growable FIFO stored in a power-of-two ring.
+ *
+ * Unlike std::deque, which allocates and frees a chunk as the queue advances, the ring keeps
+ * its storage, so a queue that has reached its working size never allocates again.
+ */
+template <typename TType>
+class RingBuffer
+{
+private:
+    std::vector<TType> _slots;
+    size_t             _head = 0;
+    size_t             _size = 0;
+
+    void grow()
+    {
+        std::vector<TType> slots(_slots.empty() ? 16 : _slots.size() * 2);
+        for (size_t i = 0; i < _size; ++i)
+            slots[i] = std::move(_slots[(_head + i) & (_slots.size() - 1)]);
+        _slots = std::move(slots);
+        _head  = 0;
+    }
+
+public:
+    bool empty() const
+    {
+        return _size == 0;
+    }
+
+    size_t size() const
+    {
+        return _size;
+    }
+
+    void push(TType value)
+    {
+        if (_size == _slots.size())
+            grow();
+        _slots[(_head + _size) & (_slots.size() - 1)] = std::move(value);
+        ++_size;
+    }
+
+    TType& front()
+    {
+        return _slots[_head];
+    }
+
+    void pop()
+    {
+        _slots[_head] = TType();
+        _head         = (_head + 1) & (_slots.size() - 1);
+        --_size;
+    }
+};
+
+#endif // !_RING_BUFFER_HPP
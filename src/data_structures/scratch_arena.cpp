@@ -0,0 +1,90 @@
+#include "scratch_arena.hpp"
+
+#include <algorithm>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <memory_resource>
+#include <new>
+
+namespace
+{
+std::byte* allocateBlock(size_t capacity)
+{
+    return capacity ? static_cast<std::byte*>(::operator new(capacity)) : nullptr;
+}
+} // namespace
+
+ScratchArena::ScratchArena(size_t capacity)
+    : _block(allocateBlock(capacity)), _capacity(capacity), _used(0), _overflowBytes(0),
+      _highWater(0)
+{
+}
+
+ScratchArena::~ScratchArena()
+{
+    releaseOverflow();
+    ::operator delete(_block);
+}
+
+void ScratchArena::reset()
+{
+    _highWater = std::max(_highWater, _used + _overflowBytes);
+    if (!_overflow.empty())
+    {
+        releaseOverflow();
+        // Grow once to what this round needed, so the next one fits in the block.
+        size_t capacity = std::bit_ceil(_used + _overflowBytes);
+        ::operator delete(_block);
+        _block    = allocateBlock(capacity);
+        _capacity = capacity;
+    }
+    _used          = 0;
+    _overflowBytes = 0;
+}
+
+size_t ScratchArena::capacity() const
+{
+    return _capacity;
+}
+
+size_t ScratchArena::used() const
+{
+    return _used + _overflowBytes;
+}
+
+size_t ScratchArena::highWater() const
+{
+    return std::max(_highWater, _used + _overflowBytes);
+}
+
+void* ScratchArena::do_allocate(size_t bytes, size_t alignment)
+{
+    uintptr_t base    = reinterpret_cast<uintptr_t>(_block);
+    uintptr_t aligned = (base + _used + alignment - 1) & ~(uintptr_t(alignment) - 1);
+    size_t    end     = aligned - base + bytes;
+    if (_block && end <= _capacity)
+    {
+        _used = end;
+        return reinterpret_cast<void*>(aligned);
+    }
+
+    void* pointer = ::operator new(bytes, std::align_val_t(alignment));
+    _overflow.push_back({pointer, alignment});
+    _overflowBytes += bytes + alignment;
+    return pointer;
+}
+
+void ScratchArena::do_deallocate(void*, size_t, size_t) {}
+
+bool ScratchArena::do_is_equal(const std::pmr::memory_resource& other) const noexcept
+{
+    return this == &other;
+}
+
+void ScratchArena::releaseOverflow()
+{
+    for (const Overflow& block : _overflow)
+        ::operator delete(block.pointer, std::align_val_t(block.alignment));
+    _overflow.clear();
+}
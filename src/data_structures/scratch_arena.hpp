@@ -0,0 +1,71 @@
+#ifndef _SCRATCH_ARENA_HPP
+#define _SCRATCH_ARENA_HPP
+
+#include <cstddef>
+#include <memory_resource>
+#include <new>
+#include <utility>
+#include <vector>
+
+/**
+ * @brief Bump allocator for memory that lives until the next reset().
+ *
+ * Allocating moves a pointer and deallocating does nothing. What does not fit in the block goes
+ * to the global allocator until reset(), which then regrows the block to the high-water mark, so
+ * a loop that resets the arena every iteration stops calling malloc after the first ones. As a
+ * std::pmr::memory_resource it also backs pmr containers:
+ * `std::pmr::vector<int> values(&arena);`.
+ */
+class ScratchArena : public std::pmr::memory_resource
+{
+public:
+    explicit ScratchArena(size_t capacity = 0);
+    ~ScratchArena() override;
+
+    ScratchArena(const ScratchArena&)            = delete;
+    ScratchArena& operator=(const ScratchArena&) = delete;
+
+    /**
+     * @brief Construct a TType in the arena.
+     * @warning Its destructor never runs: keep to types that do not need it.
+     */
+    template <typename TType, typename... TArgs>
+    TType* make(TArgs&&... args)
+    {
+        return new (allocate(sizeof(TType), alignof(TType))) TType(std::forward<TArgs>(args)...);
+    }
+
+    /**
+     * @brief Forget every allocation at once.
+     * @warning Whatever was allocated since the last reset must no longer be used.
+     */
+    void reset();
+
+    size_t capacity() const;
+    size_t used() const;
+    /** Largest amount used between two resets, overflow included. */
+    size_t highWater() const;
+
+protected:
+    void* do_allocate(size_t bytes, size_t alignment) override;
+    void  do_deallocate(void* pointer, size_t bytes, size_t alignment) override;
+    bool  do_is_equal(const std::pmr::memory_resource& other) const noexcept override;
+
+private:
+    struct Overflow
+    {
+        void*  pointer;
+        size_t alignment;
+    };
+
+    std::byte*            _block;
+    size_t                _capacity;
+    size_t                _used;
+    size_t                _overflowBytes;
+    size_t                _highWater;
+    std::vector<Overflow> _overflow;
+
+    void releaseOverflow();
+};
+
+#endif // !_SCRATCH_ARENA_HPP
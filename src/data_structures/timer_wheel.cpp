@@ -0,0 +1,167 @@
+#include "timer_wheel.hpp"
+
+#include <algorithm>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+TimerWheel::TimerWheel(uint64_t now) : _occupied{}, _now(now), _size(0)
+{
+    for (Node& head : _heads)
+    {
+        head._prev = &head;
+        head._next = &head;
+    }
+}
+
+TimerWheel::~TimerWheel()
+{
+    // Leave the nodes disarmed so their owners can still tell.
+    for (Node& head : _heads)
+    {
+        while (head._next != &head)
+            unlink(*head._next);
+    }
+}
+
+void TimerWheel::schedule(Node& node, uint64_t expires)
+{
+    if (node.scheduled())
+        unlink(node);
+    else
+        ++_size;
+    node._expires = expires;
+    place(node);
+}
+
+void TimerWheel::cancel(Node& node)
+{
+    if (!node.scheduled())
+        return;
+    unlink(node);
+    --_size;
+}
+
+void TimerWheel::advance(uint64_t now, std::vector<Node*>& expired)
+{
+    for (uint64_t next = nextEvent(); next <= now; next = nextEvent())
+    {
+        _now = next;
+        for (unsigned level = LEVELS - 1; level > 0; --level)
+        {
+            if ((_now & ((uint64_t(1) << (LEVEL_BITS * level)) - 1)) == 0)
+                cascade(level);
+        }
+        Node& head = _heads[_now & (SLOTS - 1)];
+        while (head._next != &head)
+        {
+            Node& node = *head._next;
+            unlink(node);
+            link(node, EXPIRED);
+        }
+    }
+    _now = std::max(_now, now);
+
+    Node& head = _heads[EXPIRED];
+    while (head._next != &head)
+    {
+        Node* node = head._next;
+        unlink(*node);
+        --_size;
+        expired.push_back(node);
+    }
+}
+
+uint64_t TimerWheel::nextExpiry() const
+{
+    if (_heads[EXPIRED]._next != &_heads[EXPIRED])
+        return _now;
+    return nextEvent();
+}
+
+uint64_t TimerWheel::now() const
+{
+    return _now;
+}
+
+size_t TimerWheel::size() const
+{
+    return _size;
+}
+
+bool TimerWheel::empty() const
+{
+    return _size == 0;
+}
+
+void TimerWheel::place(Node& node)
+{
+    if (node._expires <= _now)
+    {
+        link(node, EXPIRED);
+        return;
+    }
+
+    uint64_t delta = node._expires - _now;
+    unsigned level = 0;
+    while (level + 1 < LEVELS && delta >= (uint64_t(1) << (LEVEL_BITS * (level + 1))))
+        ++level;
+
+    // Beyond the top level, park in its farthest slot and look again when it comes round.
+    uint64_t range = uint64_t(1) << (LEVEL_BITS * (level + 1));
+    uint64_t at    = delta < range ? node._expires : _now + range - 1;
+    link(node, level * SLOTS + ((at >> (LEVEL_BITS * level)) & (SLOTS - 1)));
+}
+
+void TimerWheel::link(Node& node, size_t slot)
+{
+    Node& head        = _heads[slot];
+    node._prev        = head._prev;
+    node._next        = &head;
+    head._prev->_next = &node;
+    head._prev        = &node;
+    node._slot        = slot;
+    if (slot != EXPIRED)
+        _occupied[slot / SLOTS] |= uint64_t(1) << (slot % SLOTS);
+}
+
+void TimerWheel::unlink(Node& node)
+{
+    node._prev->_next = node._next;
+    node._next->_prev = node._prev;
+    node._prev        = nullptr;
+    node._next        = nullptr;
+
+    Node& head = _heads[node._slot];
+    if (node._slot != EXPIRED && head._next == &head)
+        _occupied[node._slot / SLOTS] &= ~(uint64_t(1) << (node._slot % SLOTS));
+}
+
+void TimerWheel::cascade(unsigned level)
+{
+    Node& head = _heads[level * SLOTS + ((_now >> (LEVEL_BITS * level)) & (SLOTS - 1))];
+    while (head._next != &head)
+    {
+        Node& node = *head._next;
+        unlink(node);
+        place(node);
+    }
+}
+
+uint64_t TimerWheel::nextEvent() const
+{
+    // For each level, the start of the first occupied slot after the current one.
+    uint64_t next = NEVER;
+    for (unsigned level = 0; level < LEVELS; ++level)
+    {
+        if (_occupied[level] == 0)
+            continue;
+        unsigned shift    = LEVEL_BITS * level;
+        uint64_t current  = _now >> shift;
+        uint64_t rotated  = std::rotr(_occupied[level], static_cast<int>((current + 1) % SLOTS));
+        uint64_t distance = std::countr_zero(rotated) + 1;
+        next              = std::min(next, (current + distance) << shift);
+    }
+    return next;
+}
@@ -0,0 +1,102 @@
+#ifndef _TIMER_WHEEL_HPP
+#define _TIMER_WHEEL_HPP
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/**
+ * @brief Hierarchical timer wheel over an abstract tick count.
+ *
+ * Level L has 64 slots of 64^L ticks each. A timer sits in the level matching how far away it
+ * is and moves down one level each time the wheel reaches its slot, so scheduling and cancelling
+ * are O(1) and advancing only visits the slots that hold timers: the cost follows the timers
+ * that fire, not the ones that wait. Timers are intrusive nodes owned by the caller.
+ */
+class TimerWheel
+{
+public:
+    static constexpr unsigned LEVEL_BITS = 6;
+    static constexpr unsigned LEVELS     = 6;
+    static constexpr size_t   SLOTS      = size_t(1) << LEVEL_BITS;
+    static constexpr uint64_t NEVER      = UINT64_MAX;
+
+    /**
+     * @warning A node must be cancelled (or have fired) before it is destroyed.
+     */
+    class Node
+    {
+    public:
+        bool scheduled() const
+        {
+            return _prev != nullptr;
+        }
+
+        uint64_t expires() const
+        {
+            return _expires;
+        }
+
+    private:
+        friend class TimerWheel;
+
+        Node*    _prev    = nullptr;
+        Node*    _next    = nullptr;
+        uint64_t _expires = 0;
+        size_t   _slot    = 0;
+    };
+
+    /**
+     * @param now Tick the wheel starts at.
+     */
+    explicit TimerWheel(uint64_t now = 0);
+    ~TimerWheel();
+
+    TimerWheel(const TimerWheel&)            = delete;
+    TimerWheel& operator=(const TimerWheel&) = delete;
+
+    /**
+     * @brief Arm %node to fire at tick %expires, moving it if it is already armed.
+     *
+     * A tick that is already reached fires on the next advance().
+     */
+    void schedule(Node& node, uint64_t expires);
+    void cancel(Node& node);
+
+    /**
+     * @brief Move the wheel to tick %now and append every timer due by then to %expired.
+     *
+     * Fired nodes are disarmed; the caller reschedules the periodic ones.
+     */
+    void advance(uint64_t now, std::vector<Node*>& expired);
+
+    /**
+     * @brief Earliest tick at which advance() may have something to do, or NEVER when empty.
+     *
+     * Exact for timers less than 64 ticks away; for the others it is the tick at which they move
+     * down a level, so a caller sleeping until then simply calls advance() and asks again.
+     */
+    uint64_t nextExpiry() const;
+
+    uint64_t now() const;
+    size_t   size() const;
+    bool     empty() const;
+
+private:
+    static constexpr size_t EXPIRED = LEVELS * SLOTS;
+
+    // Sentinels of the circular lists: LEVELS * SLOTS slots, then the list of due timers.
+    std::array<Node, LEVELS * SLOTS + 1> _heads;
+    std::array<uint64_t, LEVELS>         _occupied;
+    uint64_t                             _now;
+    size_t                               _size;
+
+    void     place(Node& node);
+    void     link(Node& node, size_t slot);
+    void     unlink(Node& node);
+    void     cascade(unsigned level);
+    uint64_t nextEvent() const;
+};
+
+#endif // !_TIMER_WHEEL_HPP
@@ -0,0 +1,64 @@
+#include "async_event.hpp"
+
+#include <atomic>
+#include <coroutine>
+
+AsyncEvent::AsyncEvent(bool set) : _state(set ? this : nullptr) {}
+
+const void* AsyncEvent::setState() const
+{
+    return this;
+}
+
+bool AsyncEvent::isSet() const
+{
+    return _state.load(std::memory_order_acquire) == setState();
+}
+
+void AsyncEvent::set()
+{
+    void* old = _state.exchange(const_cast<void*>(setState()), std::memory_order_acq_rel);
+    if (old == setState())
+        return;
+
+    auto* waiter = static_cast<Awaiter*>(old);
+    while (waiter)
+    {
+        // Read the link first: resuming may destroy the awaiter.
+        Awaiter* next = waiter->_next;
+        waiter->_handle.resume();
+        waiter = next;
+    }
+}
+
+void AsyncEvent::reset()
+{
+    void* expected = const_cast<void*>(setState());
+    _state.compare_exchange_strong(expected, nullptr, std::memory_order_relaxed);
+}
+
+AsyncEvent::Awaiter AsyncEvent::operator co_await() const noexcept
+{
+    return Awaiter(*this);
+}
+
+AsyncEvent::Awaiter::Awaiter(const AsyncEvent& event) : _event(event), _next(nullptr) {}
+
+bool AsyncEvent::Awaiter::await_ready() const noexcept
+{
+    return _event.isSet();
+}
+
+bool AsyncEvent::Awaiter::await_suspend(std::coroutine_handle<> handle) noexcept
+{
+    _handle   = handle;
+    void* old = _event._state.load(std::memory_order_acquire);
+    do
+    {
+        if (old == _event.setState())
+            return false;
+        _next = static_cast<Awaiter*>(old);
+    } while (!_event._state.compare_exchange_weak(
+        old, this, std::memory_order_release, std::memory_order_acquire));
+    return true;
+}
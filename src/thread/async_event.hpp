@@ -0,0 +1,51 @@
+#ifndef _ASYNC_EVENT_HPP_
+#define _ASYNC_EVENT_HPP_
+
+#include <atomic>
+#include <coroutine>
+
+/**
+ * @brief Manual-reset event that coroutines can `co_await` without blocking a thread.
+ *
+ * Waiters form an intrusive lock-free list stored in their own coroutine frames; set() resumes
+ * all of them on the calling thread.
+ */
+class AsyncEvent
+{
+public:
+    class Awaiter
+    {
+    public:
+        explicit Awaiter(const AsyncEvent& event);
+
+        bool await_ready() const noexcept;
+        bool await_suspend(std::coroutine_handle<> handle) noexcept;
+        void await_resume() const noexcept {}
+
+    private:
+        friend class AsyncEvent;
+
+        const AsyncEvent&       _event;
+        std::coroutine_handle<> _handle;
+        Awaiter*                _next;
+    };
+
+    explicit AsyncEvent(bool set = false);
+
+    AsyncEvent(const AsyncEvent&)            = delete;
+    AsyncEvent& operator=(const AsyncEvent&) = delete;
+
+    bool isSet() const;
+    void set();
+    void reset();
+
+    Awaiter operator co_await() const noexcept;
+
+private:
+    // Either setState(), or the head of the waiting list (nullptr when empty).
+    mutable std::atomic<void*> _state;
+
+    const void* setState() const;
+};
+
+#endif // !_ASYNC_EVENT_HPP_
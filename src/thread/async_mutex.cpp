@@ -0,0 +1,105 @@
+#include "async_mutex.hpp"
+
+#include <atomic>
+#include <cassert>
+#include <coroutine>
+#include <cstdint>
+
+AsyncMutex::AsyncMutex() : _state(NOT_LOCKED), _waiters(nullptr) {}
+
+AsyncMutex::~AsyncMutex()
+{
+    assert(_state.load(std::memory_order_relaxed) == NOT_LOCKED);
+}
+
+bool AsyncMutex::tryLock()
+{
+    uintptr_t expected = NOT_LOCKED;
+    return _state.compare_exchange_strong(
+        expected, LOCKED_NO_WAITERS, std::memory_order_acquire, std::memory_order_relaxed);
+}
+
+AsyncMutex::LockAwaiter AsyncMutex::lockAsync()
+{
+    return LockAwaiter(*this);
+}
+
+AsyncMutex::ScopedLockAwaiter AsyncMutex::scopedLockAsync()
+{
+    return ScopedLockAwaiter(*this);
+}
+
+void AsyncMutex::unlock()
+{
+    LockAwaiter* head = _waiters;
+    if (!head)
+    {
+        uintptr_t expected = LOCKED_NO_WAITERS;
+        if (_state.compare_exchange_strong(
+                expected, NOT_LOCKED, std::memory_order_release, std::memory_order_relaxed))
+            return;
+
+        // Take the stack of new waiters and reverse it so they are served in arrival order.
+        uintptr_t stack = _state.exchange(LOCKED_NO_WAITERS, std::memory_order_acquire);
+        auto*     next  = reinterpret_cast<LockAwaiter*>(stack);
+        while (next)
+        {
+            LockAwaiter* tmp = next->_next;
+            next->_next      = head;
+            head             = next;
+            next             = tmp;
+        }
+    }
+
+    _waiters = head->_next;
+    head->_handle.resume();
+}
+
+AsyncMutex::LockAwaiter::LockAwaiter(AsyncMutex& mutex) : _mutex(mutex), _next(nullptr) {}
+
+bool AsyncMutex::LockAwaiter::await_ready() const noexcept
+{
+    return false;
+}
+
+bool AsyncMutex::LockAwaiter::await_suspend(std::coroutine_handle<> handle) noexcept
+{
+    _handle       = handle;
+    uintptr_t old = _mutex._state.load(std::memory_order_acquire);
+    while (true)
+    {
+        if (old == NOT_LOCKED)
+        {
+            if (_mutex._state.compare_exchange_weak(
+                    old, LOCKED_NO_WAITERS, std::memory_order_acquire, std::memory_order_relaxed))
+                return false;
+        }
+        else
+        {
+            _next = reinterpret_cast<LockAwaiter*>(old);
+            if (_mutex._state.compare_exchange_weak(old,
+                                                    reinterpret_cast<uintptr_t>(this),
+                                                    std::memory_order_release,
+                                                    std::memory_order_relaxed))
+                return true;
+        }
+    }
+}
+
+AsyncMutex::Lock AsyncMutex::ScopedLockAwaiter::await_resume() const noexcept
+{
+    return Lock(_mutex);
+}
+
+AsyncMutex::Lock::Lock(AsyncMutex& mutex) : _mutex(&mutex) {}
+
+AsyncMutex::Lock::Lock(Lock&& other) noexcept : _mutex(other._mutex)
+{
+    other._mutex = nullptr;
+}
+
+AsyncMutex::Lock::~Lock()
+{
+    if (_mutex)
+        _mutex->unlock();
+}
@@ -0,0 +1,91 @@
+#ifndef _ASYNC_MUTEX_HPP_
+#define _ASYNC_MUTEX_HPP_
+
+#include <atomic>
+#include <coroutine>
+#include <cstdint>
+
+/**
+ * @brief Mutex for coroutines: a contended lock suspends the coroutine instead of the thread.
+ *
+ * New waiters push themselves on a lock-free stack; the holder reverses it into a FIFO list on
+ * unlock() and resumes the next waiter directly, handing the lock over.
+ */
+class AsyncMutex
+{
+public:
+    class LockAwaiter
+    {
+    public:
+        explicit LockAwaiter(AsyncMutex& mutex);
+
+        bool await_ready() const noexcept;
+        bool await_suspend(std::coroutine_handle<> handle) noexcept;
+        void await_resume() const noexcept {}
+
+    protected:
+        friend class AsyncMutex;
+
+        AsyncMutex&             _mutex;
+        std::coroutine_handle<> _handle;
+        LockAwaiter*            _next;
+    };
+
+    /**
+     * @brief Unlocks the mutex when it goes out of scope.
+     */
+    class Lock
+    {
+    public:
+        explicit Lock(AsyncMutex& mutex);
+        Lock(Lock&& other) noexcept;
+        Lock(const Lock&)            = delete;
+        Lock& operator=(const Lock&) = delete;
+        ~Lock();
+
+    private:
+        AsyncMutex* _mutex;
+    };
+
+    class ScopedLockAwaiter : public LockAwaiter
+    {
+    public:
+        using LockAwaiter::LockAwaiter;
+
+        Lock await_resume() const noexcept;
+    };
+
+    AsyncMutex();
+    ~AsyncMutex();
+
+    AsyncMutex(const AsyncMutex&)            = delete;
+    AsyncMutex& operator=(const AsyncMutex&) = delete;
+
+    bool tryLock();
+
+    /**
+     * @brief `co_await mutex.lockAsync();` then call unlock() yourself.
+     */
+    LockAwaiter lockAsync();
+
+    /**
+     * @brief `auto lock = co_await mutex.scopedLockAsync();`
+     */
+    ScopedLockAwaiter scopedLockAsync();
+
+    /**
+     * @note If coroutines are waiting, the first one is resumed on the calling thread.
+     */
+    void unlock();
+
+private:
+    static constexpr uintptr_t NOT_LOCKED        = 1;
+    static constexpr uintptr_t LOCKED_NO_WAITERS = 0;
+
+    // NOT_LOCKED, LOCKED_NO_WAITERS, or the head of the LIFO stack of new waiters.
+    std::atomic<uintptr_t> _state;
+    // FIFO list of waiters, only touched by the lock holder.
+    LockAwaiter* _waiters;
+};
+
+#endif // !_ASYNC_MUTEX_HPP_
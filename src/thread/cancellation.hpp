@@ -0,0 +1,90 @@
+#ifndef _CANCELLATION_HPP_
+#define _CANCELLATION_HPP_
+
+#include <atomic>
+#include <memory>
+#include <stdexcept>
+#include <utility>
+
+/**
+ * @brief Thrown by CancellationToken::throwIfCancelled().
+ */
+class OperationCancelled : public std::runtime_error
+{
+public:
+    OperationCancelled() : std::runtime_error("Operation cancelled") {}
+};
+
+/**
+ * @brief Read side of a CancellationSource, cheap to copy into jobs.
+ *
+ * Cancellation is cooperative: a job polls isCancelled() at points where it can stop cleanly.
+ * A default-constructed token is never cancelled.
+ */
+class CancellationToken
+{
+private:
+    friend class CancellationSource;
+
+    struct State;
+
+    std::shared_ptr<const State> _state;
+
+    explicit CancellationToken(std::shared_ptr<const State> state) : _state(std::move(state)) {}
+
+public:
+    CancellationToken() = default;
+
+    bool isCancelled() const;
+
+    void throwIfCancelled() const
+    {
+        if (isCancelled())
+            throw OperationCancelled();
+    }
+};
+
+struct CancellationToken::State
+{
+    std::atomic<bool> cancelled{false};
+    CancellationToken parent;
+};
+
+inline bool CancellationToken::isCancelled() const
+{
+    return _state && (_state->cancelled.load(std::memory_order_acquire) ||
+                      _state->parent.isCancelled());
+}
+
+class CancellationSource
+{
+private:
+    std::shared_ptr<CancellationToken::State> _state;
+
+public:
+    /**
+     * @param %parent Cancelling it also cancels this source.
+     */
+    explicit CancellationSource(CancellationToken parent = CancellationToken())
+        : _state(std::make_shared<CancellationToken::State>())
+    {
+        _state->parent = std::move(parent);
+    }
+
+    void cancel()
+    {
+        _state->cancelled.store(true, std::memory_order_release);
+    }
+
+    bool isCancelled() const
+    {
+        return token().isCancelled();
+    }
+
+    CancellationToken token() const
+    {
+        return CancellationToken(_state);
+    }
+};
+
+#endif // !_CANCELLATION_HPP_
@@ -0,0 +1,188 @@
+#ifndef _CONCURRENT_PRIORITY_QUEUE_HPP_
+#define _CONCURRENT_PRIORITY_QUEUE_HPP_
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+#include <utility>
+#include <vector>
+
+/**
+ * @brief Relaxed concurrent priority queue (MultiQueue).
+ *
+ * Elements are spread over several independently locked binary heaps. A pop samples two shards
+ * and takes the best of their tops, so threads rarely meet on the same lock. The price is that
+ * the popped element is only close to the highest priority one, not always the highest: the
+ * expected rank error grows with the number of shards, not with the number of elements.
+ * Within a shard, equal priorities are served in push order.
+ */
+template <typename TType>
+class ConcurrentPriorityQueue
+{
+private:
+    static constexpr int64_t EMPTY = std::numeric_limits<int64_t>::min();
+
+    struct Entry
+    {
+        int64_t  priority;
+        uint64_t sequence;
+        TType    value;
+
+        bool operator<(const Entry& other) const
+        {
+            if (priority != other.priority)
+                return priority < other.priority;
+            return sequence > other.sequence;
+        }
+    };
+
+    struct alignas(64) Shard
+    {
+        std::mutex           mtx;
+        std::vector<Entry>   heap;
+        uint64_t             sequence = 0;
+        std::atomic<int64_t> top{EMPTY};
+    };
+
+    std::unique_ptr<Shard[]> _shards;
+    size_t                   _shardCount;
+    std::atomic<size_t>      _size;
+
+    static uint64_t nextRandom()
+    {
+        thread_local uint64_t state =
+            std::hash<std::thread::id>{}(std::this_thread::get_id()) | 1;
+        state ^= state << 13;
+        state ^= state >> 7;
+        state ^= state << 17;
+        return state;
+    }
+
+    bool popLocked(Shard& shard, TType& dest)
+    {
+        if (shard.heap.empty())
+            return false;
+        std::pop_heap(shard.heap.begin(), shard.heap.end());
+        dest = std::move(shard.heap.back().value);
+        shard.heap.pop_back();
+        shard.top.store(shard.heap.empty() ? EMPTY : shard.heap.front().priority,
+                        std::memory_order_relaxed);
+        _size.fetch_sub(1, std::memory_order_relaxed);
+        return true;
+    }
+
+public:
+    /**
+     * @param shardCount Number of heaps; more shards means less contention but a looser order.
+     */
+    ConcurrentPriorityQueue(
+        size_t shardCount = 2 * std::max(1u, std::thread::hardware_concurrency()))
+        : _shards(std::make_unique<Shard[]>(std::max<size_t>(shardCount, 1))),
+          _shardCount(std::max<size_t>(shardCount, 1)), _size(0)
+    {
+    }
+
+    ConcurrentPriorityQueue(const ConcurrentPriorityQueue&)            = delete;
+    ConcurrentPriorityQueue& operator=(const ConcurrentPriorityQueue&) = delete;
+
+    /**
+     * @brief Insert %value; higher %priority values are popped first.
+     * @note INT64_MIN is reserved to mark empty shards and is treated as INT64_MIN + 1.
+     */
+    void push(const TType& value, int64_t priority)
+    {
+        priority = std::max(priority, EMPTY + 1);
+        size_t index = nextRandom() % _shardCount;
+        for (size_t attempt = 0; !_shards[index].mtx.try_lock(); ++attempt)
+        {
+            if (attempt == _shardCount)
+            {
+                _shards[index].mtx.lock();
+                break;
+            }
+            index = nextRandom() % _shardCount;
+        }
+
+        Shard&                      shard = _shards[index];
+        std::lock_guard<std::mutex> lock(shard.mtx, std::adopt_lock);
+        shard.heap.push_back(Entry{priority, shard.sequence++, value});
+        std::push_heap(shard.heap.begin(), shard.heap.end());
+        shard.top.store(shard.heap.front().priority, std::memory_order_relaxed);
+        _size.fetch_add(1, std::memory_order_release);
+    }
+
+    /**
+     * @brief Pop an element of (approximately) the highest priority into %dest.
+     * @return false if the queue was empty.
+     */
+    bool try_pop(TType& dest)
+    {
+        while (_size.load(std::memory_order_acquire) != 0)
+        {
+            for (size_t attempt = 0; attempt < _shardCount; ++attempt)
+            {
+                size_t first  = nextRandom() % _shardCount;
+                size_t second = nextRandom() % _shardCount;
+                if (_shards[second].top.load(std::memory_order_relaxed) >
+                    _shards[first].top.load(std::memory_order_relaxed))
+                    first = second;
+
+                Shard& shard = _shards[first];
+                if (shard.top.load(std::memory_order_relaxed) == EMPTY || !shard.mtx.try_lock())
+                    continue;
+                std::lock_guard<std::mutex> lock(shard.mtx, std::adopt_lock);
+                if (popLocked(shard, dest))
+                    return true;
+            }
+
+            // Sampling keeps missing: fall back to the best top over all shards.
+            size_t  best    = 0;
+            int64_t bestTop = EMPTY;
+            for (size_t i = 0; i < _shardCount; ++i)
+            {
+                int64_t top = _shards[i].top.load(std::memory_order_relaxed);
+                if (top > bestTop)
+                {
+                    best    = i;
+                    bestTop = top;
+                }
+            }
+            if (bestTop == EMPTY)
+                continue;
+            std::lock_guard<std::mutex> lock(_shards[best].mtx);
+            if (popLocked(_shards[best], dest))
+                return true;
+        }
+        return false;
+    }
+
+    TType pop()
+    {
+        TType elem;
+        if (!try_pop(elem))
+            throw std::runtime_error("Queue is empty");
+        return elem;
+    }
+
+    /**
+     * @note Only a hint under concurrency.
+     */
+    size_t size() const
+    {
+        return _size.load(std::memory_order_relaxed);
+    }
+
+    bool empty() const
+    {
+        return size() == 0;
+    }
+};
+
+#endif // !_CONCURRENT_PRIORITY_QUEUE_HPP_
@@ -0,0 +1,320 @@
+#ifndef _COROUTINE_HPP_
+#define _COROUTINE_HPP_
+
+#include <atomic>
+#include <coroutine>
+#include <cstddef>
+#include <exception>
+#include <optional>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "latch.hpp"
+
+template <typename TResult = void>
+class Task;
+
+/**
+ * @brief Receives the completion of a task started by syncWait() or whenAll().
+ */
+class CompletionSink
+{
+public:
+    virtual ~CompletionSink() = default;
+
+    /**
+     * @return The coroutine to resume next, or std::noop_coroutine().
+     */
+    virtual std::coroutine_handle<> complete() noexcept = 0;
+};
+
+class TaskPromiseBase
+{
+public:
+    struct FinalAwaiter
+    {
+        bool await_ready() const noexcept
+        {
+            return false;
+        }
+
+        template <typename TPromise>
+        std::coroutine_handle<> await_suspend(std::coroutine_handle<TPromise> handle) noexcept
+        {
+            TaskPromiseBase& promise = handle.promise();
+            if (promise._sink)
+                return promise._sink->complete();
+            if (promise._continuation)
+                return promise._continuation;
+            return std::noop_coroutine();
+        }
+
+        void await_resume() noexcept {}
+    };
+
+    std::suspend_always initial_suspend() noexcept
+    {
+        return {};
+    }
+
+    FinalAwaiter final_suspend() noexcept
+    {
+        return {};
+    }
+
+    void unhandled_exception() noexcept
+    {
+        _exception = std::current_exception();
+    }
+
+    void setContinuation(std::coroutine_handle<> continuation) noexcept
+    {
+        _continuation = continuation;
+    }
+
+    void setSink(CompletionSink* sink) noexcept
+    {
+        _sink = sink;
+    }
+
+protected:
+    std::coroutine_handle<> _continuation;
+    CompletionSink*         _sink = nullptr;
+    std::exception_ptr      _exception;
+
+    void rethrow()
+    {
+        if (_exception)
+            std::rethrow_exception(_exception);
+    }
+};
+
+template <typename TResult>
+class TaskPromise : public TaskPromiseBase
+{
+private:
+    std::optional<TResult> _value;
+
+public:
+    Task<TResult> get_return_object() noexcept;
+
+    template <typename TValue>
+    void return_value(TValue&& value)
+    {
+        _value.emplace(std::forward<TValue>(value));
+    }
+
+    TResult result()
+    {
+        rethrow();
+        return std::move(*_value);
+    }
+};
+
+template <>
+class TaskPromise<void> : public TaskPromiseBase
+{
+public:
+    Task<void> get_return_object() noexcept;
+
+    void return_void() noexcept {}
+
+    void result()
+    {
+        rethrow();
+    }
+};
+
+/**
+ * @brief Lazily started coroutine producing a TResult.
+ *
+ * Nothing runs until the task is awaited (or handed to syncWait / whenAll). A task that wants to
+ * run on a pool starts with `co_await pool.schedule();`. Awaiting a task resumes the awaiting
+ * coroutine on whatever thread finished the task, by symmetric transfer, so long chains do not
+ * grow the stack.
+ */
+template <typename TResult>
+class Task
+{
+public:
+    using promise_type = TaskPromise<TResult>;
+
+    Task() = default;
+    explicit Task(std::coroutine_handle<promise_type> handle) : _handle(handle) {}
+
+    Task(Task&& other) noexcept : _handle(std::exchange(other._handle, nullptr)) {}
+
+    Task& operator=(Task&& other) noexcept
+    {
+        if (this != &other)
+        {
+            if (_handle)
+                _handle.destroy();
+            _handle = std::exchange(other._handle, nullptr);
+        }
+        return *this;
+    }
+
+    Task(const Task&)            = delete;
+    Task& operator=(const Task&) = delete;
+
+    ~Task()
+    {
+        if (_handle)
+            _handle.destroy();
+    }
+
+    bool done() const
+    {
+        return !_handle || _handle.done();
+    }
+
+    auto operator co_await() noexcept
+    {
+        struct Awaiter
+        {
+            std::coroutine_handle<promise_type> handle;
+
+            bool await_ready() const noexcept
+            {
+                return !handle || handle.done();
+            }
+
+            std::coroutine_handle<> await_suspend(std::coroutine_handle<> awaiting) noexcept
+            {
+                handle.promise().setContinuation(awaiting);
+                return handle;
+            }
+
+            TResult await_resume()
+            {
+                return handle.promise().result();
+            }
+        };
+        return Awaiter{_handle};
+    }
+
+    /**
+     * @brief Start the task and report its completion to %sink instead of a continuation.
+     */
+    void start(CompletionSink& sink)
+    {
+        _handle.promise().setSink(&sink);
+        _handle.resume();
+    }
+
+    /**
+     * @brief Result of a finished task; rethrows the exception it ended with.
+     */
+    TResult result()
+    {
+        return _handle.promise().result();
+    }
+
+private:
+    std::coroutine_handle<promise_type> _handle;
+};
+
+template <typename TResult>
+Task<TResult> TaskPromise<TResult>::get_return_object() noexcept
+{
+    return Task<TResult>(std::coroutine_handle<TaskPromise>::from_promise(*this));
+}
+
+inline Task<void> TaskPromise<void>::get_return_object() noexcept
+{
+    return Task<void>(std::coroutine_handle<TaskPromise>::from_promise(*this));
+}
+
+/**
+ * @brief Run %task to completion from ordinary code and return its result.
+ *
+ * The calling thread blocks on a Latch; the task itself runs wherever it schedules itself.
+ */
+template <typename TResult>
+TResult syncWait(Task<TResult> task)
+{
+    class Sink : public CompletionSink
+    {
+    public:
+        Latch done{1};
+
+        std::coroutine_handle<> complete() noexcept override
+        {
+            done.countDown();
+            return std::noop_coroutine();
+        }
+    } sink;
+
+    task.start(sink);
+    sink.done.wait();
+    return task.result();
+}
+
+/**
+ * @brief Start every task at once and resume the caller when the last one finishes.
+ * @return The results in the order of %tasks; rethrows the first failure in that order.
+ */
+template <typename TResult>
+auto whenAll(std::vector<Task<TResult>> tasks)
+    -> Task<std::conditional_t<std::is_void_v<TResult>, void, std::vector<TResult>>>
+{
+    class Counter : public CompletionSink
+    {
+    public:
+        std::atomic<size_t>     remaining;
+        std::coroutine_handle<> parent;
+
+        bool arrive() noexcept
+        {
+            return remaining.fetch_sub(1, std::memory_order_acq_rel) == 1;
+        }
+
+        std::coroutine_handle<> complete() noexcept override
+        {
+            return arrive() ? parent : std::noop_coroutine();
+        }
+    };
+
+    struct Awaiter
+    {
+        std::vector<Task<TResult>>& tasks;
+        Counter                     counter;
+
+        bool await_ready() const noexcept
+        {
+            return tasks.empty();
+        }
+
+        bool await_suspend(std::coroutine_handle<> handle)
+        {
+            // One extra count for ourselves so no task can resume us before all are started.
+            counter.remaining.store(tasks.size() + 1, std::memory_order_relaxed);
+            counter.parent = handle;
+            for (auto& task : tasks)
+                task.start(counter);
+            return !counter.arrive();
+        }
+
+        void await_resume() noexcept {}
+    };
+
+    co_await Awaiter{tasks, {}};
+
+    if constexpr (std::is_void_v<TResult>)
+    {
+        for (auto& task : tasks)
+            task.result();
+    }
+    else
+    {
+        std::vector<TResult> results;
+        results.reserve(tasks.size());
+        for (auto& task : tasks)
+            results.push_back(task.result());
+        co_return results;
+    }
+}
+
+#endif // !_COROUTINE_HPP_
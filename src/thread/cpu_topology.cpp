@@ -0,0 +1,177 @@
+#include "cpu_topology.hpp"
+
+#include <sched.h>
+
+#include <algorithm>
+#include <charconv>
+#include <fstream>
+#include <set>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <vector>
+
+namespace
+{
+const std::string SYS_CPU = "/sys/devices/system/cpu/cpu";
+
+bool readLine(const std::string& path, std::string& line)
+{
+    std::ifstream file(path);
+    return file && std::getline(file, line);
+}
+
+// sysfs is read on a best-effort basis: text that is not a plain number counts as missing.
+bool parseInt(std::string_view text, int& value)
+{
+    size_t first = text.find_first_not_of(" \t\n");
+    size_t last  = text.find_last_not_of(" \t\n");
+    if (first == std::string_view::npos)
+        return false;
+    const char* begin = text.data() + first;
+    const char* end   = text.data() + last + 1;
+    auto [stop, error] = std::from_chars(begin, end, value);
+    return error == std::errc() && stop == end;
+}
+
+// Lowest CPU of the list stored at %path, or %fallback.
+int firstOf(const std::string& path, int fallback)
+{
+    std::string line;
+    if (!readLine(path, line))
+        return fallback;
+    std::vector<int> cpus = CpuTopology::parseCpuList(line);
+    return cpus.empty() ? fallback : cpus.front();
+}
+
+int lastLevelCache(int cpu)
+{
+    int bestLevel = -1;
+    int cache     = 0;
+    for (int index = 0;; ++index)
+    {
+        std::string dir = SYS_CPU + std::to_string(cpu) + "/cache/index" + std::to_string(index);
+        std::string text;
+        std::string type;
+        int         level;
+        if (!readLine(dir + "/level", text))
+            break;
+        if (!parseInt(text, level) || (readLine(dir + "/type", type) && type == "Instruction"))
+            continue;
+        if (level > bestLevel)
+        {
+            bestLevel = level;
+            cache     = firstOf(dir + "/shared_cpu_list", cache);
+        }
+    }
+    return cache;
+}
+} // namespace
+
+CpuTopology::CpuTopology()
+{
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    if (sched_getaffinity(0, sizeof(set), &set) != 0)
+        return;
+
+    for (int id = 0; id < CPU_SETSIZE; ++id)
+    {
+        if (!CPU_ISSET(id, &set))
+            continue;
+
+        std::string topology = SYS_CPU + std::to_string(id) + "/topology/";
+        std::string package;
+
+        Cpu cpu;
+        cpu.id      = id;
+        cpu.core    = firstOf(topology + "thread_siblings_list", id);
+        cpu.cache   = lastLevelCache(id);
+        if (!readLine(topology + "physical_package_id", package)
+            || !parseInt(package, cpu.package))
+            cpu.package = 0;
+        _cpus.push_back(cpu);
+    }
+
+    std::sort(_cpus.begin(),
+              _cpus.end(),
+              [](const Cpu& a, const Cpu& b)
+              {
+                  if (a.package != b.package)
+                      return a.package < b.package;
+                  if (a.cache != b.cache)
+                      return a.cache < b.cache;
+                  if (a.core != b.core)
+                      return a.core < b.core;
+                  return a.id < b.id;
+              });
+}
+
+const std::vector<CpuTopology::Cpu>& CpuTopology::cpus() const
+{
+    return _cpus;
+}
+
+size_t CpuTopology::coreCount() const
+{
+    std::set<int> cores;
+    for (const Cpu& cpu : _cpus)
+        cores.insert(cpu.core);
+    return cores.size();
+}
+
+size_t CpuTopology::cacheCount() const
+{
+    std::set<int> caches;
+    for (const Cpu& cpu : _cpus)
+        caches.insert(cpu.cache);
+    return caches.size();
+}
+
+std::vector<CpuTopology::Cpu> CpuTopology::coresFirst(const std::vector<Cpu>& cpus)
+{
+    // Rank of each CPU among the SMT siblings of its core, which are consecutive.
+    std::vector<size_t> rank(cpus.size(), 0);
+    for (size_t i = 1; i < cpus.size(); ++i)
+    {
+        if (cpus[i].core == cpus[i - 1].core)
+            rank[i] = rank[i - 1] + 1;
+    }
+
+    std::vector<Cpu> ordered;
+    ordered.reserve(cpus.size());
+    for (size_t pass = 0; ordered.size() < cpus.size(); ++pass)
+    {
+        for (size_t i = 0; i < cpus.size(); ++i)
+        {
+            if (rank[i] == pass)
+                ordered.push_back(cpus[i]);
+        }
+    }
+    return ordered;
+}
+
+std::vector<int> CpuTopology::parseCpuList(const std::string& list)
+{
+    std::vector<int>  cpus;
+    std::stringstream stream(list);
+    std::string       range;
+    while (std::getline(stream, range, ','))
+    {
+        // Blank or malformed entries are skipped.
+        std::string_view text(range);
+        size_t           dash = text.find('-');
+        int              first;
+        int              last;
+        if (!parseInt(text.substr(0, dash), first))
+            continue;
+        if (dash == std::string_view::npos)
+            last = first;
+        else if (!parseInt(text.substr(dash + 1), last))
+            continue;
+        for (int cpu = first; cpu <= last; ++cpu)
+            cpus.push_back(cpu);
+    }
+    return cpus;
+}
@@ -0,0 +1,51 @@
+#ifndef _CPU_TOPOLOGY_HPP_
+#define _CPU_TOPOLOGY_HPP_
+
+#include <string>
+#include <vector>
+
+/**
+ * @brief CPUs the calling thread may run on, with the core and last-level cache each one
+ * belongs to.
+ *
+ * Built from sched_getaffinity() and /sys/devices/system/cpu. A core or cache is identified by
+ * the lowest CPU sharing it, so ids are comparable across CPUs. When /sys is not readable every
+ * CPU counts as its own core and all of them share one cache.
+ */
+class CpuTopology
+{
+public:
+    struct Cpu
+    {
+        int id;
+        int core;
+        int cache;
+        int package;
+    };
+
+    CpuTopology();
+
+    /**
+     * @brief Allowed CPUs, sorted by package, cache, core then id.
+     */
+    const std::vector<Cpu>& cpus() const;
+
+    size_t coreCount() const;
+    size_t cacheCount() const;
+
+    /**
+     * @brief %cpus, sorted as cpus() is, reordered so that no core gets a second CPU before
+     * every core has one: the first CPU of each core cache by cache, then the second, and so on.
+     */
+    static std::vector<Cpu> coresFirst(const std::vector<Cpu>& cpus);
+
+    /**
+     * @brief Parse a kernel CPU list such as "0-3,8,10-11".
+     */
+    static std::vector<int> parseCpuList(const std::string& list);
+
+private:
+    std::vector<Cpu> _cpus;
+};
+
+#endif // !_CPU_TOPOLOGY_HPP_
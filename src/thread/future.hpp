@@ -0,0 +1,301 @@
+#ifndef _FUTURE_HPP_
+#define _FUTURE_HPP_
+
+#include <atomic>
+#include <coroutine>
+#include <cstdint>
+#include <exception>
+#include <future>
+#include <optional>
+#include <type_traits>
+#include <utility>
+
+/**
+ * @brief Shared state between a Promise (or a pool job) and its Future.
+ *
+ * Reference counted and waited on with atomic wait/notify, so there is no mutex or condition
+ * variable per result. A single coroutine may also register itself to be resumed by whichever
+ * thread publishes the result. Subclasses may override recycle() to reuse the state instead of
+ * freeing it once both sides are done with it.
+ */
+template <typename TResult>
+class FutureState
+{
+private:
+    struct Empty
+    {
+    };
+    using Value = std::conditional_t<std::is_void_v<TResult>, Empty, TResult>;
+
+    static constexpr uint32_t PENDING = 0;
+    static constexpr uint32_t READY   = 1;
+
+    std::atomic<uint32_t> _status;
+    std::atomic<uint32_t> _refs;
+    std::atomic<void*>    _continuation;
+    std::optional<Value>  _value;
+    std::exception_ptr    _exception;
+
+    // Marks _continuation once the result is published.
+    void* published()
+    {
+        return this;
+    }
+
+    void publish()
+    {
+        _status.store(READY, std::memory_order_release);
+        _status.notify_all();
+        void* continuation = _continuation.exchange(published(), std::memory_order_acq_rel);
+        if (continuation)
+            std::coroutine_handle<>::from_address(continuation).resume();
+    }
+
+protected:
+    /**
+     * @brief Put a recycled state back to pending with %refs owners.
+     */
+    void rearm(uint32_t refs)
+    {
+        _value.reset();
+        _exception = nullptr;
+        _refs.store(refs, std::memory_order_relaxed);
+        _continuation.store(nullptr, std::memory_order_relaxed);
+        _status.store(PENDING, std::memory_order_relaxed);
+    }
+
+    virtual void recycle()
+    {
+        delete this;
+    }
+
+public:
+    FutureState(uint32_t refs = 1) : _status(PENDING), _refs(refs), _continuation(nullptr) {}
+    virtual ~FutureState() = default;
+
+    FutureState(const FutureState&)            = delete;
+    FutureState& operator=(const FutureState&) = delete;
+
+    template <typename... TValue>
+    void setValue(TValue&&... value)
+    {
+        _value.emplace(std::forward<TValue>(value)...);
+        publish();
+    }
+
+    void setException(std::exception_ptr exception)
+    {
+        _exception = exception;
+        publish();
+    }
+
+    bool ready() const
+    {
+        return _status.load(std::memory_order_acquire) == READY;
+    }
+
+    void wait() const
+    {
+        while (_status.load(std::memory_order_acquire) != READY)
+            _status.wait(PENDING, std::memory_order_acquire);
+    }
+
+    /**
+     * @brief Resume %handle once the result is published.
+     * @return false if it already is, in which case %handle is not stored.
+     */
+    bool suspend(std::coroutine_handle<> handle)
+    {
+        void* expected = nullptr;
+        return _continuation.compare_exchange_strong(
+            expected, handle.address(), std::memory_order_acq_rel);
+    }
+
+    /**
+     * @brief Wait, then move the value out or rethrow the stored exception.
+     */
+    TResult take()
+    {
+        wait();
+        if (_exception)
+            std::rethrow_exception(_exception);
+        if constexpr (!std::is_void_v<TResult>)
+            return std::move(*_value);
+    }
+
+    void retain()
+    {
+        _refs.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    void release()
+    {
+        if (_refs.fetch_sub(1, std::memory_order_acq_rel) == 1)
+            recycle();
+    }
+};
+
+template <typename TResult>
+class Future
+{
+private:
+    FutureState<TResult>* _state = nullptr;
+
+    FutureState<TResult>* checked() const
+    {
+        if (!_state)
+            throw std::future_error(std::future_errc::no_state);
+        return _state;
+    }
+
+public:
+    Future() = default;
+
+    /**
+     * @brief Adopt one reference on %state.
+     */
+    explicit Future(FutureState<TResult>* state) : _state(state) {}
+
+    Future(Future&& other) noexcept : _state(std::exchange(other._state, nullptr)) {}
+
+    Future& operator=(Future&& other) noexcept
+    {
+        if (this != &other)
+        {
+            if (_state)
+                _state->release();
+            _state = std::exchange(other._state, nullptr);
+        }
+        return *this;
+    }
+
+    Future(const Future&)            = delete;
+    Future& operator=(const Future&) = delete;
+
+    ~Future()
+    {
+        if (_state)
+            _state->release();
+    }
+
+    bool valid() const
+    {
+        return _state != nullptr;
+    }
+
+    bool ready() const
+    {
+        return checked()->ready();
+    }
+
+    void wait() const
+    {
+        checked()->wait();
+    }
+
+    /**
+     * @brief `co_await std::move(future)` suspends the coroutine until the result is published,
+     * then returns it like get().
+     */
+    auto operator co_await() &&
+    {
+        struct Awaiter
+        {
+            Future future;
+
+            bool await_ready() const
+            {
+                return future.ready();
+            }
+
+            bool await_suspend(std::coroutine_handle<> handle)
+            {
+                return future._state->suspend(handle);
+            }
+
+            TResult await_resume()
+            {
+                return future.get();
+            }
+        };
+        return Awaiter{std::move(*this)};
+    }
+
+    /**
+     * @brief Block until the result is available, then return it or rethrow its exception.
+     * @note The future is no longer valid afterwards.
+     * @warning Blocking on a pool job from inside a job of the same pool can deadlock.
+     */
+    TResult get()
+    {
+        struct Release
+        {
+            FutureState<TResult>* state;
+            ~Release()
+            {
+                state->release();
+            }
+        } guard{checked()};
+        _state = nullptr;
+        return guard.state->take();
+    }
+};
+
+template <typename TResult>
+class Promise
+{
+private:
+    FutureState<TResult>* _state;
+    bool                  _retrieved = false;
+
+    void checkPending() const
+    {
+        if (_state->ready())
+            throw std::future_error(std::future_errc::promise_already_satisfied);
+    }
+
+public:
+    Promise() : _state(new FutureState<TResult>()) {}
+
+    Promise(Promise&& other) noexcept
+        : _state(std::exchange(other._state, nullptr)), _retrieved(other._retrieved)
+    {
+    }
+
+    Promise(const Promise&)            = delete;
+    Promise& operator=(const Promise&) = delete;
+
+    ~Promise()
+    {
+        if (!_state)
+            return;
+        if (!_state->ready())
+            _state->setException(
+                std::make_exception_ptr(std::future_error(std::future_errc::broken_promise)));
+        _state->release();
+    }
+
+    Future<TResult> getFuture()
+    {
+        if (_retrieved)
+            throw std::future_error(std::future_errc::future_already_retrieved);
+        _retrieved = true;
+        _state->retain();
+        return Future<TResult>(_state);
+    }
+
+    template <typename... TValue>
+    void setValue(TValue&&... value)
+    {
+        checkPending();
+        _state->setValue(std::forward<TValue>(value)...);
+    }
+
+    void setException(std::exception_ptr exception)
+    {
+        checkPending();
+        _state->setException(exception);
+    }
+};
+
+#endif // !_FUTURE_HPP_
@@ -0,0 +1,66 @@
+#include "hazard_pointer.hpp"
+
+#include <atomic>
+#include <cstddef>
+
+std::atomic<HazardPointer::Record*> HazardPointer::_records{nullptr};
+std::atomic<size_t>                 HazardPointer::_recordCount{0};
+
+HazardPointer::Owner::Owner() : record(HazardPointer::acquire()) {}
+
+HazardPointer::Owner::~Owner()
+{
+    for (auto& hazard : record->hazards)
+        hazard.store(nullptr, std::memory_order_release);
+    record->active.store(false, std::memory_order_release);
+}
+
+HazardPointer::Record* HazardPointer::acquire()
+{
+    for (Record* rec = _records.load(std::memory_order_acquire); rec; rec = rec->next)
+    {
+        bool expected = false;
+        if (!rec->active.load(std::memory_order_relaxed) &&
+            rec->active.compare_exchange_strong(expected, true, std::memory_order_acq_rel))
+            return rec;
+    }
+
+    Record* rec = new Record();
+    for (auto& hazard : rec->hazards)
+        hazard.store(nullptr, std::memory_order_relaxed);
+    rec->active.store(true, std::memory_order_relaxed);
+    rec->next = _records.load(std::memory_order_relaxed);
+    while (!_records.compare_exchange_weak(rec->next, rec, std::memory_order_acq_rel))
+        ;
+    _recordCount.fetch_add(1, std::memory_order_relaxed);
+    return rec;
+}
+
+std::atomic<void*>& HazardPointer::slot(size_t index)
+{
+    thread_local Owner owner;
+    return owner.record->hazards[index];
+}
+
+void HazardPointer::clear(size_t index)
+{
+    slot(index).store(nullptr, std::memory_order_release);
+}
+
+bool HazardPointer::isHazard(const void* ptr)
+{
+    for (Record* rec = _records.load(std::memory_order_acquire); rec; rec = rec->next)
+    {
+        for (auto& hazard : rec->hazards)
+        {
+            if (hazard.load() == ptr)
+                return true;
+        }
+    }
+    return false;
+}
+
+size_t HazardPointer::recordCount()
+{
+    return _recordCount.load(std::memory_order_relaxed);
+}
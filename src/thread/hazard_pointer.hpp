@@ -0,0 +1,73 @@
+#ifndef _HAZARD_POINTER_HPP_
+#define _HAZARD_POINTER_HPP_
+
+#include <atomic>
+#include <cstddef>
+
+/**
+ * @brief Process-wide hazard pointer domain.
+ *
+ * Every thread owns a record of SLOTS hazard pointers, acquired lazily on first use and handed
+ * back when the thread exits. A node published in one of those slots must not be reused or freed
+ * by any other thread. Records are never freed, so a scan can always walk the whole list.
+ */
+class HazardPointer
+{
+public:
+    static constexpr size_t SLOTS = 2;
+
+    /**
+     * @brief Publish the current value of %src in slot %index and return it once it is stable.
+     */
+    template <typename TType>
+    static TType* protect(size_t index, const std::atomic<TType*>& src)
+    {
+        std::atomic<void*>& hazard = slot(index);
+        TType*              ptr    = src.load();
+        while (true)
+        {
+            hazard.store(ptr);
+            TType* check = src.load();
+            if (check == ptr)
+                return ptr;
+            ptr = check;
+        }
+    }
+
+    static void clear(size_t index);
+
+    /**
+     * @brief Tell if any thread currently holds %ptr in one of its slots.
+     */
+    static bool isHazard(const void* ptr);
+
+    /**
+     * @brief Number of records ever handed out, used to size retire thresholds.
+     */
+    static size_t recordCount();
+
+private:
+    struct Record
+    {
+        std::atomic<void*> hazards[SLOTS];
+        std::atomic<bool>  active;
+        Record*            next;
+    };
+
+    class Owner
+    {
+    public:
+        Owner();
+        ~Owner();
+
+        Record* record;
+    };
+
+    static std::atomic<Record*> _records;
+    static std::atomic<size_t>  _recordCount;
+
+    static std::atomic<void*>& slot(size_t index);
+    static Record*             acquire();
+};
+
+#endif // !_HAZARD_POINTER_HPP_
@@ -0,0 +1,71 @@
+#ifndef _LATCH_HPP_
+#define _LATCH_HPP_
+
+#include <atomic>
+#include <cstddef>
+#include <thread>
+
+#include "spin_wait.hpp"
+
+/**
+ * @brief Single-use countdown, waited on with atomic wait/notify.
+ *
+ * Lives wherever its owner puts it (usually the stack) and never allocates. Unlike std::latch it
+ * can be re-armed with reset() once every waiter has returned.
+ *
+ * The count reaching zero does not open the latch yet: the thread that brought it there first
+ * wakes the sleepers, then opens it with a plain store, its last access. A waiter that sees the
+ * latch open may therefore destroy it right away.
+ */
+class Latch
+{
+private:
+    static constexpr ptrdiff_t OPEN = -1;
+
+    std::atomic<ptrdiff_t> _count;
+
+public:
+    explicit Latch(ptrdiff_t count = 0) : _count(count > 0 ? count : OPEN) {}
+
+    Latch(const Latch&)            = delete;
+    Latch& operator=(const Latch&) = delete;
+
+    /**
+     * @warning Only call while nobody is waiting or counting down.
+     */
+    void reset(ptrdiff_t count)
+    {
+        _count.store(count > 0 ? count : OPEN, std::memory_order_relaxed);
+    }
+
+    void countDown(ptrdiff_t n = 1)
+    {
+        if (_count.fetch_sub(n, std::memory_order_acq_rel) == n)
+        {
+            _count.notify_all();
+            _count.store(OPEN, std::memory_order_release);
+        }
+    }
+
+    bool tryWait() const
+    {
+        return _count.load(std::memory_order_acquire) == OPEN;
+    }
+
+    void wait(const WaitPolicy& policy = WaitPolicy()) const
+    {
+        if (spinUntil(policy, [this] { return tryWait(); }))
+            return;
+        ptrdiff_t count;
+        while ((count = _count.load(std::memory_order_acquire)) != OPEN)
+        {
+            // Zero only lasts while the last thread notifies.
+            if (count == 0)
+                std::this_thread::yield();
+            else
+                _count.wait(count, std::memory_order_acquire);
+        }
+    }
+};
+
+#endif // !_LATCH_HPP_
@@ -0,0 +1,276 @@
+#ifndef _LOCK_FREE_QUEUE_HPP_
+#define _LOCK_FREE_QUEUE_HPP_
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+
+#include "hazard_pointer.hpp"
+
+/**
+ * @brief Unbounded multi-producer multi-consumer queue (Michael & Scott).
+ *
+ * Dequeued nodes are retired, then recycled through an internal free list once no hazard
+ * pointer references them, so a queue that has reached its working size stops allocating.
+ * Memory is only given back to the system when the queue is destroyed.
+ *
+ * Nodes come from %TAllocator, rebound to the node type.
+ */
+template <typename TType, typename TAllocator = std::allocator<TType>>
+class LockFreeQueue
+{
+    // try_pop_front() unlinks the node before moving the value out: a throwing move would lose it.
+    static_assert(std::is_nothrow_move_assignable_v<TType>,
+                  "LockFreeQueue requires a nothrow move assignment");
+
+private:
+    struct Node
+    {
+        std::atomic<Node*> next;
+        std::atomic<Node*> link; // free list / retired list chaining
+        alignas(TType) unsigned char storage[sizeof(TType)];
+
+        TType* value()
+        {
+            return std::launder(reinterpret_cast<TType*>(storage));
+        }
+    };
+
+    alignas(64) std::atomic<Node*> _head;
+    alignas(64) std::atomic<Node*> _tail;
+    alignas(64) std::atomic<Node*> _free;
+    alignas(64) std::atomic<Node*> _retired;
+    std::atomic<size_t> _retiredCount;
+    std::atomic<bool>   _scanning;
+
+    using NodeAllocator = typename std::allocator_traits<TAllocator>::template rebind_alloc<Node>;
+    using NodeTraits    = std::allocator_traits<NodeAllocator>;
+    NodeAllocator _allocator;
+
+    static constexpr size_t RETIRE_THRESHOLD = 64;
+
+    Node* newNode()
+    {
+        Node* node = NodeTraits::allocate(_allocator, 1);
+        NodeTraits::construct(_allocator, node);
+        return node;
+    }
+
+    void deleteNode(Node* node)
+    {
+        NodeTraits::destroy(_allocator, node);
+        NodeTraits::deallocate(_allocator, node, 1);
+    }
+
+    static void pushList(std::atomic<Node*>& list, Node* node)
+    {
+        Node* top = list.load(std::memory_order_relaxed);
+        do
+        {
+            node->link.store(top, std::memory_order_relaxed);
+        } while (!list.compare_exchange_weak(top, node, std::memory_order_release));
+    }
+
+    Node* allocate()
+    {
+        Node* top;
+        while ((top = HazardPointer::protect(0, _free)) != nullptr)
+        {
+            Node* next = top->link.load(std::memory_order_relaxed);
+            if (_free.compare_exchange_strong(top, next, std::memory_order_acquire))
+                break;
+        }
+        HazardPointer::clear(0);
+        if (top == nullptr)
+            top = newNode();
+        top->next.store(nullptr, std::memory_order_relaxed);
+        return top;
+    }
+
+    void retire(Node* node)
+    {
+        size_t threshold =
+            RETIRE_THRESHOLD + 2 * HazardPointer::SLOTS * HazardPointer::recordCount();
+        size_t retired   = _retiredCount.fetch_add(1, std::memory_order_relaxed) + 1;
+        pushList(_retired, node);
+        if (retired >= threshold)
+            scan();
+    }
+
+    void scan()
+    {
+        if (_scanning.exchange(true, std::memory_order_acquire))
+            return;
+
+        Node*  node  = _retired.exchange(nullptr, std::memory_order_acquire);
+        size_t freed = 0;
+        while (node)
+        {
+            Node* next = node->link.load(std::memory_order_relaxed);
+            if (HazardPointer::isHazard(node))
+            {
+                pushList(_retired, node);
+            }
+            else
+            {
+                pushList(_free, node);
+                ++freed;
+            }
+            node = next;
+        }
+        _retiredCount.fetch_sub(freed, std::memory_order_relaxed);
+        _scanning.store(false, std::memory_order_release);
+    }
+
+    void deleteList(Node* node)
+    {
+        while (node)
+        {
+            Node* next = node->link.load(std::memory_order_relaxed);
+            deleteNode(node);
+            node = next;
+        }
+    }
+
+    template <typename TArg>
+    void emplace(TArg&& arg)
+    {
+        Node* node = allocate();
+        try
+        {
+            new (node->storage) TType(std::forward<TArg>(arg));
+        }
+        catch (...)
+        {
+            // Another thread may still hold a hazard on the node from allocate(): retire it
+            // rather than pushing it straight back to _free.
+            retire(node);
+            throw;
+        }
+
+        while (true)
+        {
+            Node* tail = HazardPointer::protect(0, _tail);
+            Node* next = tail->next.load(std::memory_order_acquire);
+            if (tail != _tail.load())
+                continue;
+            if (next == nullptr)
+            {
+                if (tail->next.compare_exchange_weak(next, node))
+                {
+                    _tail.compare_exchange_strong(tail, node);
+                    break;
+                }
+            }
+            else
+            {
+                _tail.compare_exchange_strong(tail, next);
+            }
+        }
+        HazardPointer::clear(0);
+    }
+
+public:
+    explicit LockFreeQueue(const TAllocator& allocator = TAllocator())
+        : _retiredCount(0), _scanning(false), _allocator(allocator)
+    {
+        Node* dummy = newNode();
+        dummy->next.store(nullptr, std::memory_order_relaxed);
+        _head.store(dummy, std::memory_order_relaxed);
+        _tail.store(dummy, std::memory_order_relaxed);
+        _free.store(nullptr, std::memory_order_relaxed);
+        _retired.store(nullptr, std::memory_order_relaxed);
+    }
+
+    LockFreeQueue(const LockFreeQueue&)            = delete;
+    LockFreeQueue& operator=(const LockFreeQueue&) = delete;
+
+    /**
+     * @warning Must not run concurrently with any other operation on the queue.
+     */
+    ~LockFreeQueue()
+    {
+        Node* node = _head.load(std::memory_order_relaxed);
+        Node* next = node->next.load(std::memory_order_relaxed);
+        deleteNode(node);
+        while (next)
+        {
+            node = next;
+            next = node->next.load(std::memory_order_relaxed);
+            node->value()->~TType();
+            deleteNode(node);
+        }
+        deleteList(_free.load(std::memory_order_relaxed));
+        deleteList(_retired.load(std::memory_order_relaxed));
+    }
+
+    void push_back(const TType& newElement)
+    {
+        emplace(newElement);
+    }
+
+    void push_back(TType&& newElement)
+    {
+        emplace(std::move(newElement));
+    }
+
+    /**
+     * @brief Move the oldest element into %dest.
+     * @return false if the queue was empty.
+     */
+    bool try_pop_front(TType& dest)
+    {
+        while (true)
+        {
+            Node* head = HazardPointer::protect(0, _head);
+            Node* tail = _tail.load();
+            Node* next = HazardPointer::protect(1, head->next);
+            if (head != _head.load())
+                continue;
+            if (next == nullptr)
+            {
+                HazardPointer::clear(0);
+                HazardPointer::clear(1);
+                return false;
+            }
+            if (head == tail)
+            {
+                _tail.compare_exchange_strong(tail, next);
+                continue;
+            }
+            if (_head.compare_exchange_strong(head, next))
+            {
+                // Only the winner touches the value; next stays protected until it is moved out.
+                dest = std::move(*next->value());
+                next->value()->~TType();
+                HazardPointer::clear(0);
+                HazardPointer::clear(1);
+                retire(head);
+                return true;
+            }
+        }
+    }
+
+    TType pop_front()
+    {
+        TType elem;
+        if (!try_pop_front(elem))
+            throw std::runtime_error("Queue is empty");
+        return elem;
+    }
+
+    /**
+     * @note Only a hint under concurrency.
+     */
+    bool empty() const
+    {
+        Node* head = _head.load(std::memory_order_acquire);
+        return head->next.load(std::memory_order_acquire) == nullptr;
+    }
+};
+
+#endif // !_LOCK_FREE_QUEUE_HPP_
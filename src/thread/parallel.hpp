@@ -0,0 +1,277 @@
+#ifndef _PARALLEL_HPP_
+#define _PARALLEL_HPP_
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <exception>
+#include <functional>
+#include <iterator>
+#include <optional>
+#include <utility>
+
+#include "latch.hpp"
+#include "worker_pool.hpp"
+
+inline constexpr size_t PARALLEL_MAX_HELPERS = 64;
+
+/**
+ * @brief Split [0, size) into chunks claimed on demand by the calling thread and up to
+ * MAX_HELPERS pool jobs.
+ *
+ * Chunks are guided: each claim takes max(grain, remaining / (2 * participants)) indices, so
+ * early chunks are large and the tail is split finely for load balance. Everything lives on the
+ * caller's stack; the pool only ever sees pointers to the helper jobs below.
+ */
+template <typename TBody>
+class ParallelRange
+{
+public:
+    static constexpr size_t MAX_HELPERS = PARALLEL_MAX_HELPERS;
+
+    /**
+     * @param body Called as body(participant, first, last) for each claimed chunk. participant
+     * is 0 for the caller and 1..helpers for pool jobs.
+     */
+    static void run(WorkerPool& pool, size_t size, size_t grain, TBody& body)
+    {
+        if (size == 0)
+            return;
+        grain = std::max<size_t>(grain, 1);
+
+        size_t helpers = std::min({pool.workerCount(), (size - 1) / grain, MAX_HELPERS});
+        if (helpers == 0)
+        {
+            body(0, 0, size);
+            return;
+        }
+
+        ParallelRange range(size, grain, helpers, body);
+        for (size_t i = 0; i < helpers; ++i)
+        {
+            range._helpers[i].range       = &range;
+            range._helpers[i].participant = i + 1;
+            pool.addJob(&range._helpers[i]);
+        }
+
+        range.work(0);
+
+        // Help with whatever is queued rather than blocking a worker that called us.
+        while (!range._done.tryWait())
+        {
+            if (!pool.runPendingJob())
+            {
+                range._done.wait();
+                break;
+            }
+        }
+
+        if (range._exception)
+            std::rethrow_exception(range._exception);
+    }
+
+private:
+    class Helper : public WorkerPool::IJob
+    {
+    public:
+        ParallelRange* range       = nullptr;
+        size_t         participant = 0;
+
+        void execute() override
+        {
+            ParallelRange* owner = range;
+            owner->work(participant);
+            // Last access: the caller may return as soon as the latch opens.
+            owner->_done.countDown();
+        }
+    };
+
+    alignas(64) std::atomic<size_t> _next;
+    size_t                               _size;
+    size_t                               _grain;
+    size_t                               _participants;
+    TBody&                               _body;
+    Latch                                _done;
+    std::atomic<bool>                    _failed;
+    std::exception_ptr                   _exception;
+    std::array<Helper, MAX_HELPERS>      _helpers;
+
+    ParallelRange(size_t size, size_t grain, size_t helpers, TBody& body)
+        : _next(0), _size(size), _grain(grain), _participants(helpers + 1), _body(body),
+          _done(helpers), _failed(false)
+    {
+    }
+
+    bool claim(size_t& first, size_t& last)
+    {
+        first = _next.load(std::memory_order_relaxed);
+        while (first < _size)
+        {
+            size_t chunk = std::max(_grain, (_size - first) / (2 * _participants));
+            last         = std::min(_size, first + chunk);
+            if (_next.compare_exchange_weak(first, last, std::memory_order_relaxed))
+                return true;
+        }
+        return false;
+    }
+
+    void work(size_t participant)
+    {
+        size_t first;
+        size_t last;
+        try
+        {
+            while (claim(first, last))
+                _body(participant, first, last);
+        }
+        catch (...)
+        {
+            if (!_failed.exchange(true))
+                _exception = std::current_exception();
+            _next.store(_size, std::memory_order_relaxed);
+        }
+    }
+};
+
+template <typename TBody>
+void parallel_chunks(WorkerPool& pool, size_t size, size_t grain, TBody&& body)
+{
+    ParallelRange<std::remove_reference_t<TBody>>::run(pool, size, grain, body);
+}
+
+/**
+ * @brief Call %func(i) for every i in [%first, %last).
+ * @param grain Smallest chunk handed to a participant; 0 picks one from the pool size.
+ */
+template <typename TIndex, typename TFunc>
+void parallel_for(WorkerPool& pool, TIndex first, TIndex last, TFunc&& func, size_t grain = 0)
+{
+    if (last <= first)
+        return;
+    size_t size = static_cast<size_t>(last - first);
+    if (grain == 0)
+        grain = std::max<size_t>(1, size / (8 * (pool.workerCount() + 1)));
+
+    parallel_chunks(pool,
+                    size,
+                    grain,
+                    [&](size_t, size_t begin, size_t end)
+                    {
+                        for (size_t i = begin; i != end; ++i)
+                            func(static_cast<TIndex>(first + i));
+                    });
+}
+
+/**
+ * @brief Fold [%first, %last) with %reduce, starting from %init.
+ * @note %reduce must be associative and commutative: chunks are combined in completion order.
+ */
+template <typename TIterator, typename TValue, typename TReduce>
+TValue parallel_reduce(WorkerPool& pool,
+                       TIterator   first,
+                       TIterator   last,
+                       TValue      init,
+                       TReduce     reduce,
+                       size_t      grain = 0)
+{
+    size_t size = static_cast<size_t>(std::distance(first, last));
+    if (grain == 0)
+        grain = std::max<size_t>(1, size / (8 * (pool.workerCount() + 1)));
+
+    std::array<std::optional<TValue>, PARALLEL_MAX_HELPERS + 1> partials;
+    parallel_chunks(pool,
+                    size,
+                    grain,
+                    [&](size_t participant, size_t begin, size_t end)
+                    {
+                        TIterator it  = first + begin;
+                        TValue    acc = *it;
+                        for (++it; it != first + end; ++it)
+                            acc = reduce(std::move(acc), *it);
+                        auto& partial = partials[participant];
+                        partial = partial ? reduce(std::move(*partial), std::move(acc)) : acc;
+                    });
+
+    for (auto& partial : partials)
+    {
+        if (partial)
+            init = reduce(std::move(init), std::move(*partial));
+    }
+    return init;
+}
+
+/**
+ * @brief out[i] = func(in[i]) for each element of [%first, %last).
+ * @return Iterator past the last written element.
+ */
+template <typename TInput, typename TOutput, typename TFunc>
+TOutput parallel_transform(WorkerPool& pool,
+                           TInput      first,
+                           TInput      last,
+                           TOutput     out,
+                           TFunc       func,
+                           size_t      grain = 0)
+{
+    size_t size = static_cast<size_t>(std::distance(first, last));
+    if (grain == 0)
+        grain = std::max<size_t>(1, size / (8 * (pool.workerCount() + 1)));
+
+    parallel_chunks(pool,
+                    size,
+                    grain,
+                    [&](size_t, size_t begin, size_t end)
+                    { std::transform(first + begin, first + end, out + begin, func); });
+    return out + size;
+}
+
+/**
+ * @brief Sort blocks in parallel, then merge neighbouring runs pairwise, each round in parallel.
+ * @param grain Below this many elements a range is sorted serially.
+ */
+template <typename TIterator, typename TCompare = std::less<>>
+void parallel_sort(WorkerPool& pool,
+                   TIterator   first,
+                   TIterator   last,
+                   TCompare    comp  = TCompare(),
+                   size_t      grain = 1 << 14)
+{
+    size_t size   = static_cast<size_t>(std::distance(first, last));
+    size_t blocks = 1;
+    while (blocks < pool.workerCount() + 1 && size / (blocks * 2) >= std::max<size_t>(grain, 1))
+        blocks *= 2;
+    if (blocks == 1)
+    {
+        std::sort(first, last, comp);
+        return;
+    }
+
+    auto bound = [&](size_t block) { return first + size * block / blocks; };
+
+    parallel_chunks(pool,
+                    blocks,
+                    1,
+                    [&](size_t, size_t begin, size_t end)
+                    {
+                        for (size_t b = begin; b != end; ++b)
+                            std::sort(bound(b), bound(b + 1), comp);
+                    });
+
+    for (size_t width = 1; width < blocks; width *= 2)
+    {
+        parallel_chunks(pool,
+                        blocks / (2 * width),
+                        1,
+                        [&](size_t, size_t begin, size_t end)
+                        {
+                            for (size_t pair = begin; pair != end; ++pair)
+                            {
+                                size_t b = pair * 2 * width;
+                                std::inplace_merge(
+                                    bound(b), bound(b + width), bound(b + 2 * width), comp);
+                            }
+                        });
+    }
+}
+
+#endif // !_PARALLEL_HPP_
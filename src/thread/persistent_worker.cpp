@@ -1,79 +1,580 @@
 #include "persistent_worker.hpp"
 
+#include <pthread.h>
+
+#include <algorithm>
+#include <atomic>
 #include <chrono>
+#include <cmath>
+#include <cstdint>
 #include <exception>
 #include <functional>
 #include <memory>
 #include <mutex>
+#include <stdexcept>
 #include <string>
 #include <thread>
 #include <unordered_map>
 #include <vector>
 
-PersistentWorker::PersistentWorker(std::chrono::milliseconds tick) : _stop(false), _tick(tick)
+#include "thread_stats.hpp"
+
+double PersistentWorker::Task::load() const
+{
+    return 1.0 / static_cast<double>(interval);
+}
+
+PersistentWorker::PersistentWorker(std::chrono::milliseconds tick, const WaitPolicy& wait)
+    : PersistentWorker(Options{.tick = tick, .wait = wait})
+{
+}
+
+PersistentWorker::PersistentWorker(const Options& options)
+    : _released(nullptr), _stop(false), _placement(options.placement), _name(options.name),
+      _tick(std::max(options.tick, std::chrono::milliseconds(1))), _wait(options.wait),
+      _epoch(std::chrono::steady_clock::now())
 {
-    _worker = std::thread(&PersistentWorker::runtime, this);
+    size_t count = std::max<size_t>(options.threads, 1);
+    for (size_t i = 0; i < count; ++i)
+        _shards.push_back(std::make_unique<Shard>());
+    for (size_t i = 0; i < count; ++i)
+        _shards[i]->thread = std::thread(&PersistentWorker::runtime, this, i);
 }
 
 PersistentWorker::~PersistentWorker()
 {
+    _stop.store(true);
+    for (auto& shard : _shards)
+        wake(*shard);
+
+    for (auto& shard : _shards)
     {
-        std::lock_guard<std::mutex> lock(_mtx);
-        _stop = true;
+        if (shard->thread.joinable())
+            shard->thread.join();
     }
-    _cv.notify_all();
+}
 
-    if (_worker.joinable())
+PersistentWorker::TaskHandle PersistentWorker::addTask(const std::function<void()>& func,
+                                                      const TaskOptions&           options)
+{
+    check(options);
+    std::lock_guard<std::mutex> lock(_mtx);
+    return add(make(func, options), options.shard);
+}
+
+PersistentWorker::TaskHandle PersistentWorker::addTask(const std::function<void()>& func)
+{
+    return addTask(func, TaskOptions());
+}
+
+bool PersistentWorker::removeTask(TaskHandle handle)
+{
+    std::lock_guard<std::mutex> lock(_mtx);
+    Task*                       task = find(handle);
+    if (!task)
+        return false;
+    erase(*task);
+    rebalance();
+    return true;
+}
+
+PersistentWorker::TaskHandle PersistentWorker::addTask(const std::string&           name,
+                                                      const std::function<void()>& func)
+{
+    return addTask(name, func, TaskOptions());
+}
+
+PersistentWorker::TaskHandle PersistentWorker::addTask(const std::string&           name,
+                                                      const std::function<void()>& func,
+                                                      std::chrono::milliseconds    interval,
+                                                      std::chrono::milliseconds    delay)
+{
+    return addTask(name, func, TaskOptions{.interval = interval, .delay = delay});
+}
+
+PersistentWorker::TaskHandle PersistentWorker::addTask(const std::string&           name,
+                                                      const std::function<void()>& func,
+                                                      const TaskOptions&           options)
+{
+    check(options);
+    std::lock_guard<std::mutex> lock(_mtx);
+    auto                        it = _names.find(name);
+    if (it != _names.end())
+        erase(get(it->second));
+    Task* task        = make(func, options);
+    task->name        = name;
+    TaskHandle handle = add(task, options.shard);
+    _names[name]      = handle;
+    return handle;
+}
+
+void PersistentWorker::removeTask(const std::string& name)
+{
+    std::lock_guard<std::mutex> lock(_mtx);
+    auto                        it = _names.find(name);
+    if (it == _names.end())
+        return;
+    erase(get(it->second));
+    rebalance();
+}
+
+PersistentWorker::TaskStats PersistentWorker::taskStats(TaskHandle handle)
+{
+    std::lock_guard<std::mutex> lock(_mtx);
+    const Body&                 body = *get(handle).body;
+
+    TaskStats stats;
+    stats.runs   = body.runs.load(std::memory_order_relaxed);
+    stats.missed = body.missed.load(std::memory_order_relaxed);
+    if (body.histograms)
     {
-        _worker.join();
+        stats.jitter    = body.histograms->jitter.snapshot();
+        stats.execution = body.histograms->execution.snapshot();
     }
+    return stats;
 }
 
-void PersistentWorker::addTask(const std::string& name, const std::function<void()>& func)
+PersistentWorker::TaskStats PersistentWorker::taskStats(const std::string& name)
+{
+    TaskHandle handle;
+    {
+        std::lock_guard<std::mutex> lock(_mtx);
+        auto                        it = _names.find(name);
+        if (it == _names.end())
+            throw std::out_of_range("PersistentWorker: unknown task " + name);
+        handle = it->second;
+    }
+    return taskStats(handle);
+}
+
+size_t PersistentWorker::shardOf(TaskHandle handle)
 {
     std::lock_guard<std::mutex> lock(_mtx);
-    _jobs[name] = std::make_shared<std::function<void()>>(func);
-    _cv.notify_one();
+    return get(handle).shard;
 }
 
-void PersistentWorker::removeTask(const std::string& name)
+size_t PersistentWorker::shardOf(const std::string& name)
 {
     std::lock_guard<std::mutex> lock(_mtx);
-    _jobs.erase(name);
+    auto                        it = _names.find(name);
+    if (it == _names.end())
+        throw std::out_of_range("PersistentWorker: unknown task " + name);
+    return get(it->second).shard;
+}
+
+size_t PersistentWorker::threadCount() const
+{
+    return _shards.size();
+}
+
+std::vector<ThreadStats> PersistentWorker::threadStats() const
+{
+    return ThreadRegistry::instance().snapshot(this);
+}
+
+uint64_t PersistentWorker::currentTick() const
+{
+    return (std::chrono::steady_clock::now() - _epoch) / _tick;
+}
+
+uint64_t PersistentWorker::ticks(std::chrono::milliseconds duration) const
+{
+    if (duration <= std::chrono::milliseconds(0))
+        return 0;
+    return (duration + _tick - std::chrono::milliseconds(1)) / _tick;
+}
+
+void PersistentWorker::check(const TaskOptions& options) const
+{
+    if (options.shard != ANY_SHARD && options.shard >= _shards.size())
+        throw std::out_of_range("PersistentWorker: no such shard");
+}
+
+PersistentWorker::Task* PersistentWorker::make(const std::function<void()>& func,
+                                               const TaskOptions&           options)
+{
+    reclaim();
+    Body* body;
+    if (_freeBodies.empty())
+    {
+        _bodyPool.push_back(std::make_unique<Body>());
+        body = _bodyPool.back().get();
+    }
+    else
+    {
+        body = _freeBodies.back();
+        _freeBodies.pop_back();
+    }
+    body->func = func;
+    body->busy.store(false, std::memory_order_relaxed);
+    body->next.store(0, std::memory_order_relaxed);
+    body->runs.store(0, std::memory_order_relaxed);
+    body->missed.store(0, std::memory_order_relaxed);
+    if (options.stats)
+        body->histograms = std::make_unique<Histograms>();
+    else
+        body->histograms.reset();
+    body->copies = 1;
+
+    Task* task     = acquire();
+    task->body     = body;
+    task->interval = std::max<uint64_t>(ticks(options.interval), 1);
+    task->start    = currentTick() + ticks(options.delay);
+    task->pinned   = options.shard != ANY_SHARD;
+    task->schedule = options.schedule;
+    task->overrun  = options.overrun;
+    return task;
 }
 
-void PersistentWorker::runtime()
+PersistentWorker::Task* PersistentWorker::acquire()
 {
-    while (true)
+    if (_freeTasks.empty())
     {
-        std::vector<std::shared_ptr<std::function<void()>>> copy;
+        _taskPool.push_back(std::make_unique<Task>());
+        return _taskPool.back().get();
+    }
+    Task* task = _freeTasks.back();
+    _freeTasks.pop_back();
+    task->name.clear();
+    task->removed.store(false, std::memory_order_relaxed);
+    return task;
+}
+
+PersistentWorker::TaskHandle PersistentWorker::add(Task* task, size_t shard)
+{
+    if (_freeSlots.empty())
+    {
+        _freeSlots.push_back(static_cast<uint32_t>(_slots.size()));
+        _slots.emplace_back();
+    }
+    task->slot = _freeSlots.back();
+    _freeSlots.pop_back();
+    if (shard == ANY_SHARD)
+        shard = choose(task->name.empty() ? task->slot : std::hash<std::string>()(task->name));
+    task->shard = shard;
+
+    Slot& slot = _slots[task->slot];
+    slot.task  = task;
+    attach(task);
+    return TaskHandle{task->slot, slot.generation};
+}
+
+PersistentWorker::Task* PersistentWorker::find(TaskHandle handle)
+{
+    if (handle.index >= _slots.size() || _slots[handle.index].generation != handle.generation)
+        return nullptr;
+    return _slots[handle.index].task;
+}
+
+PersistentWorker::Task& PersistentWorker::get(TaskHandle handle)
+{
+    Task* task = find(handle);
+    if (!task)
+        throw std::out_of_range("PersistentWorker: stale task handle");
+    return *task;
+}
+
+void PersistentWorker::erase(Task& task)
+{
+    if (!task.name.empty())
+        _names.erase(task.name);
+
+    // Bumping the generation is what makes every copy of the handle stale.
+    Slot& slot = _slots[task.slot];
+    if (++slot.generation == 0)
+        slot.generation = 1;
+    _freeSlots.push_back(task.slot);
+
+    slot.task = nullptr;
+    detach(task);
+}
+
+void PersistentWorker::reclaim()
+{
+    if (_released.load(std::memory_order_relaxed) == nullptr)
+        return;
+
+    Task* task = _released.exchange(nullptr, std::memory_order_acquire);
+    while (task)
+    {
+        Task* next = task->nextRemoved;
+        if (--task->body->copies == 0)
+        {
+            // Drop what the function captured now rather than at the next addTask().
+            task->body->func = nullptr;
+            _freeBodies.push_back(task->body);
+        }
+        _freeTasks.push_back(task);
+        task = next;
+    }
+}
+
+size_t PersistentWorker::choose(size_t key) const
+{
+    if (_placement == Placement::Hash)
+        return key % _shards.size();
+
+    size_t least = 0;
+    for (size_t i = 1; i < _shards.size(); ++i)
+    {
+        if (_shards[i]->load < _shards[least]->load)
+            least = i;
+    }
+    return least;
+}
+
+void PersistentWorker::attach(Task* task)
+{
+    Shard& shard   = *_shards[task->shard];
+    task->position = shard.tasks.size();
+    shard.load += task->load();
+    shard.tasks.push_back(task);
+    push(shard.added, task, &Task::nextAdded);
+    wake(shard);
+}
+
+void PersistentWorker::detach(Task& task)
+{
+    task.removed.store(true, std::memory_order_relaxed);
+
+    Shard& shard = *_shards[task.shard];
+    shard.load -= task.load();
+    shard.tasks[task.position]           = shard.tasks.back();
+    shard.tasks[task.position]->position = task.position;
+    shard.tasks.pop_back();
+    // The shard releases the task once it has unlinked it from its wheel.
+    push(shard.removed, &task, &Task::nextRemoved);
+    wake(shard);
+}
+
+void PersistentWorker::rebalance()
+{
+    if (_placement != Placement::Balanced || _shards.size() < 2)
+        return;
+
+    size_t most  = 0;
+    size_t least = 0;
+    for (size_t i = 1; i < _shards.size(); ++i)
+    {
+        if (_shards[i]->load > _shards[most]->load)
+            most = i;
+        if (_shards[i]->load < _shards[least]->load)
+            least = i;
+    }
+
+    // Moving a task of load w leaves a gap of |gap - 2w|: pick the task closest to half of it
+    // among the next REBALANCE_SCAN ones, so that churn does not rescan the whole shard.
+    Shard& from  = *_shards[most];
+    size_t count = std::min(from.tasks.size(), REBALANCE_SCAN);
+    double gap   = from.load - _shards[least]->load;
+    double best  = gap;
+    Task*  old   = nullptr;
+    for (size_t i = 0; i < count; ++i)
+    {
+        Task*  task = from.tasks[(from.cursor + i) % from.tasks.size()];
+        double left = std::abs(gap - 2 * task->load());
+        if (!task->pinned && left < best)
+        {
+            best = left;
+            old  = task;
+        }
+    }
+    from.cursor = count ? (from.cursor + count) % from.tasks.size() : 0;
+    if (!old)
+        return;
+
+    uint64_t next   = old->body->next.load(std::memory_order_relaxed);
+    Task*    moved  = acquire();
+    moved->body     = old->body;
+    moved->interval = old->interval;
+    moved->schedule = old->schedule;
+    moved->overrun  = old->overrun;
+    moved->name     = old->name;
+    moved->slot     = old->slot;
+    moved->start    = std::max(old->start, next);
+    moved->shard    = least;
+    moved->body->copies++;
+
+    // The handle keeps its slot and generation: it follows the task to its new shard.
+    _slots[moved->slot].task = moved;
+    detach(*old);
+    attach(moved);
+}
+
+void PersistentWorker::push(std::atomic<Task*>& list, Task* task, Task* Task::*link)
+{
+    Task* head = list.load(std::memory_order_relaxed);
+    do
+    {
+        task->*link = head;
+    } while (!list.compare_exchange_weak(
+        head, task, std::memory_order_release, std::memory_order_relaxed));
+}
+
+void PersistentWorker::wake(Shard& shard)
+{
+    // Whoever clears the flag owes the sleeping thread exactly one release.
+    if (shard.sleeping.exchange(false))
+        shard.wakeup.release();
+}
+
+void PersistentWorker::apply(Shard& shard)
+{
+    // Removals first: a task is pushed there after its addition, which is therefore either in
+    // the list taken next or was applied before.
+    Task* removed = shard.removed.exchange(nullptr, std::memory_order_acquire);
+    Task* added   = shard.added.exchange(nullptr, std::memory_order_acquire);
+
+    for (; added; added = added->nextAdded)
+    {
+        added->body->next.store(added->start, std::memory_order_relaxed);
+        shard.wheel.schedule(*added, added->start);
+    }
+    while (removed)
+    {
+        Task* next = removed->nextRemoved;
+        shard.wheel.cancel(*removed);
+        push(_released, removed, &Task::nextRemoved);
+        removed = next;
+    }
+}
+
+void PersistentWorker::sleep(Shard& shard)
+{
+    auto woken = [&]
+    { return shard.added.load() != nullptr || shard.removed.load() != nullptr || _stop.load(); };
+    if (spinUntil(_wait, woken))
+        return;
+
+    bool acquired = false;
+    shard.sleeping.store(true);
+    if (!woken())
+    {
+        uint64_t next = shard.wheel.nextExpiry();
+        if (next == TimerWheel::NEVER)
+        {
+            shard.wakeup.acquire();
+            acquired = true;
+        }
+        else
         {
-            std::unique_lock<std::mutex> lock(_mtx);
-            _cv.wait_for(lock, _tick, [this] { return !_jobs.empty() || _stop; });
+            // Bounded so that a far timer with a coarse tick cannot overflow the clock.
+            uint64_t limit  = currentTick() + std::max<uint64_t>(std::chrono::hours(1) / _tick, 1);
+            auto     wakeAt = _epoch + _tick * static_cast<int64_t>(std::min(next, limit));
+            acquired        = shard.wakeup.try_acquire_until(wakeAt);
+        }
+    }
+    // A writer cleared the flag after we stopped waiting: take its release so that the
+    // semaphore is empty again for the next sleep.
+    if (!shard.sleeping.exchange(false) && !acquired)
+        shard.wakeup.acquire();
+}
 
-            if (_stop)
-                return;
+void PersistentWorker::runtime(size_t index)
+{
+    Shard&                shard = *_shards[index];
+    ThreadRegistry::Scope registration((_name.empty() ? "persistent" : _name) + "-"
+                                           + std::to_string(index),
+                                       this);
+    if (!_name.empty())
+    {
+        std::string name = _name + "-" + std::to_string(index);
+        name.resize(std::min<size_t>(name.size(), 15));
+        pthread_setname_np(pthread_self(), name.c_str());
+    }
+
+    std::vector<TimerWheel::Node*> due;
+    while (!_stop.load())
+    {
+        apply(shard);
+
+        due.clear();
+        shard.wheel.advance(currentTick(), due);
+        if (due.empty())
+        {
+            sleep(shard);
+            continue;
+        }
 
-            for (auto& pair : _jobs)
-            {
-                copy.push_back(pair.second);
-            }
+        // Removed tasks are only released by the next apply().
+        for (TimerWheel::Node* node : due)
+        {
+            Task& task = static_cast<Task&>(*node);
+            // A task just moved here may still be running on its previous shard: skip a turn.
+            if (task.removed.load(std::memory_order_relaxed) ||
+                task.body->busy.exchange(true, std::memory_order_acquire))
+                continue;
+            run(task);
+            task.body->busy.store(false, std::memory_order_release);
         }
-        for (auto& func : copy)
+
+        uint64_t now = currentTick();
+        for (TimerWheel::Node* node : due)
         {
-            try
-            {
-                (*func)();
-            }
-            catch (...)
-            {
-                std::lock_guard<std::mutex> lock(_mtxExceptions);
-                _exceptions.push(std::current_exception());
-            }
+            Task& task = static_cast<Task&>(*node);
+            if (task.removed.load(std::memory_order_relaxed))
+                continue;
+            uint64_t next = following(task, now);
+            task.body->next.store(next, std::memory_order_relaxed);
+            shard.wheel.schedule(task, next);
         }
     }
 }
 
+void PersistentWorker::run(Task& task)
+{
+    Body&                                 body     = *task.body;
+    uint64_t                              deadline = task.expires();
+    std::chrono::steady_clock::time_point start;
+    if (body.histograms || task.schedule == Schedule::FixedRate)
+        start = std::chrono::steady_clock::now();
+
+    // Started once the following deadline had passed already.
+    if (task.schedule == Schedule::FixedRate &&
+        static_cast<uint64_t>((start - _epoch) / _tick) >= deadline + task.interval)
+        body.missed.fetch_add(1, std::memory_order_relaxed);
+    if (body.histograms)
+    {
+        auto late = start - (_epoch + _tick * static_cast<int64_t>(deadline));
+        body.histograms->jitter.record(std::max<int64_t>(
+            std::chrono::duration_cast<std::chrono::nanoseconds>(late).count(), 0));
+    }
+
+    try
+    {
+        body.func();
+    }
+    catch (...)
+    {
+        std::lock_guard<std::mutex> lock(_mtxExceptions);
+        _exceptions.push(std::current_exception());
+    }
+
+    body.runs.fetch_add(1, std::memory_order_relaxed);
+    if (body.histograms)
+    {
+        auto elapsed = std::chrono::steady_clock::now() - start;
+        body.histograms->execution.record(
+            std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count());
+    }
+}
+
+uint64_t PersistentWorker::following(Task& task, uint64_t now)
+{
+    if (task.schedule == Schedule::FixedDelay)
+        return now + task.interval;
+
+    // Stay on the grid of the first deadline, however long the run took.
+    uint64_t next = task.expires() + task.interval;
+    if (next < now && task.overrun == Overrun::Skip)
+    {
+        uint64_t behind = (now - next + task.interval - 1) / task.interval;
+        task.body->missed.fetch_add(behind, std::memory_order_relaxed);
+        next += behind * task.interval;
+    }
+    return next;
+}
+
 std::vector<std::exception_ptr> PersistentWorker::getExceptions()
 {
     std::vector<std::exception_ptr> result;
@@ -1,49 +1,308 @@
 #ifndef _PERSISTENT_WORKER_HPP
 #define _PERSISTENT_WORKER_HPP
 
+#include <atomic>
 #include <chrono>
-#include <condition_variable>
+#include <cstdint>
 #include <exception>
 #include <functional>
 #include <memory>
 #include <mutex>
 #include <queue>
+#include <semaphore>
 #include <string>
 #include <thread>
 #include <unordered_map>
 #include <vector>
 
+#include "pool_metrics.hpp"
+#include "spin_wait.hpp"
+#include "thread_stats.hpp"
+#include "timer_wheel.hpp"
+
+/**
+ * @brief Threads running registered tasks periodically.
+ *
+ * Tasks are spread over one or more shards, each a thread with its own TimerWheel counted in
+ * ticks. A shard sleeps until its next task is due, so a wakeup only costs the tasks it runs,
+ * however many are registered. addTask() and removeTask() push the task onto a lock-free list
+ * of additions or removals that the shard's thread takes with one atomic exchange and applies in
+ * O(1) per change: between changes, a wakeup neither allocates nor takes a lock. Removed tasks
+ * and their bodies are pooled for the next addTask().
+ */
 class PersistentWorker
 {
+public:
+    static constexpr size_t ANY_SHARD = static_cast<size_t>(-1);
+
+    enum class Placement
+    {
+        /** Each task goes to the least loaded shard, and removals move tasks to even out the
+         * load, counted as runs per tick. */
+        Balanced,
+        /** The shard follows from the hash of the name and never changes. */
+        Hash,
+    };
+
+    struct Options
+    {
+        size_t    threads   = 1;
+        Placement placement = Placement::Balanced;
+        /** Granularity of the schedule, and the period of tasks added without one. */
+        std::chrono::milliseconds tick = std::chrono::milliseconds(1);
+        /** Threads are named "<name>-<index>", cut to the 15 characters Linux keeps. */
+        std::string name = "persistent";
+        /** How long an idle shard polls for task changes before sleeping. */
+        WaitPolicy wait = WaitPolicy();
+    };
+
+    enum class Schedule
+    {
+        /** The next run is due one interval after the previous one ended. */
+        FixedDelay,
+        /** Runs are due on a fixed grid of deadlines, start + n * interval, so the period does
+         * not stretch with the execution time. */
+        FixedRate,
+    };
+
+    /** What a FixedRate task does about deadlines that passed while it was late. */
+    enum class Overrun
+    {
+        /** Run once for each of them, back to back, until the task is on time again. */
+        CatchUp,
+        /** Drop them and resume at the next deadline still ahead. */
+        Skip,
+    };
+
+    struct TaskOptions
+    {
+        /** Rounded up to whole ticks; 0 means one tick. */
+        std::chrono::milliseconds interval = std::chrono::milliseconds(0);
+        std::chrono::milliseconds delay    = std::chrono::milliseconds(0);
+        /** Pin the task to this shard instead of letting the placement choose. */
+        size_t   shard    = ANY_SHARD;
+        Schedule schedule = Schedule::FixedDelay;
+        Overrun  overrun  = Overrun::CatchUp;
+        /** Record the jitter and execution histograms of taskStats(). */
+        bool stats = false;
+    };
+
+    /**
+     * @brief Generational index of a task, valid until the task is removed.
+     *
+     * A stale handle never matches the task that later reuses its slot, and looking one up is
+     * an array access: no name is hashed nor allocated.
+     */
+    struct TaskHandle
+    {
+        uint32_t index      = 0;
+        uint32_t generation = 0;
+
+        bool valid() const
+        {
+            return generation != 0;
+        }
+
+        bool operator==(const TaskHandle&) const = default;
+    };
+
+    struct TaskStats
+    {
+        uint64_t runs = 0;
+        /** FixedRate deadlines whose run started after the following deadline, or skipped. */
+        uint64_t missed = 0;
+        /** How late each run started after its deadline; empty unless TaskOptions::stats. */
+        LatencyHistogram jitter;
+        LatencyHistogram execution;
+    };
+
 private:
-    std::thread                                                             _worker;
-    std::unordered_map<std::string, std::shared_ptr<std::function<void()>>> _jobs;
-    std::queue<std::exception_ptr>                                          _exceptions;
+    // What a task runs, shared by the copies a migration leaves on two shards.
+    struct Histograms
+    {
+        ConcurrentLatencyHistogram jitter;
+        ConcurrentLatencyHistogram execution;
+    };
+
+    struct Body
+    {
+        std::function<void()> func;
+        // Keeps the old and the new shard from running it at once.
+        std::atomic<bool> busy{false};
+        // Tick of the next run, kept by the owning shard for a migration to resume from.
+        std::atomic<uint64_t>       next{0};
+        std::atomic<uint64_t>       runs{0};
+        std::atomic<uint64_t>       missed{0};
+        std::unique_ptr<Histograms> histograms;
+        // Under _mtx: task copies not yet released by their shard.
+        uint32_t copies = 0;
+    };
+
+    struct Task : public TimerWheel::Node
+    {
+        Body*    body     = nullptr;
+        uint64_t interval = 1;
+        uint64_t start    = 0;
+        size_t   shard    = 0;
+        bool     pinned   = false;
+        Schedule schedule = Schedule::FixedDelay;
+        Overrun  overrun  = Overrun::CatchUp;
+        // Only for the named API and debugging; empty for tasks added by handle.
+        std::string name;
+        // Slot of the handle, and position in its shard's task list.
+        uint32_t slot     = 0;
+        size_t   position = 0;
+        // Set by removeTask(), checked by the shard before each run.
+        std::atomic<bool> removed{false};
+        // Links of the shard's change lists, then of _released.
+        Task* nextAdded   = nullptr;
+        Task* nextRemoved = nullptr;
+
+        double load() const;
+    };
+
+    struct Shard
+    {
+        std::thread thread;
+        // Tasks added and removed since the thread last looked, pushed under _mtx.
+        std::atomic<Task*>    added{nullptr};
+        std::atomic<Task*>    removed{nullptr};
+        TimerWheel            wheel;
+        std::binary_semaphore wakeup{0};
+        std::atomic<bool>     sleeping{false};
+        // Under _mtx: the tasks of the shard, the sum of their loads and where rebalance()
+        // resumes its search.
+        std::vector<Task*> tasks;
+        double             load   = 0;
+        size_t             cursor = 0;
+    };
+
+    struct Slot
+    {
+        Task*    task       = nullptr;
+        uint32_t generation = 1;
+    };
+
+    // Tasks examined by one rebalance(), so that a removal costs the same with any task count.
+    static constexpr size_t REBALANCE_SCAN = 64;
+
+    // Pools of every task and body ever allocated, reused once the shards release them. Declared
+    // before _shards: the wheels unlink their tasks when they are destroyed.
+    std::vector<std::unique_ptr<Task>> _taskPool;
+    std::vector<std::unique_ptr<Body>> _bodyPool;
+    std::vector<Task*>                 _freeTasks;
+    std::vector<Body*>                 _freeBodies;
+    // Removed tasks the shards are done with, pushed by the shard threads.
+    std::atomic<Task*> _released;
+
+    std::vector<std::unique_ptr<Shard>> _shards;
+    std::queue<std::exception_ptr>      _exceptions;
+
+    // Under _mtx.
+    std::vector<Slot>                           _slots;
+    std::vector<uint32_t>                       _freeSlots;
+    std::unordered_map<std::string, TaskHandle> _names;
+
+    std::mutex        _mtx;
+    std::mutex        _mtxExceptions;
+    std::atomic<bool> _stop;
 
-    std::mutex              _mtx;
-    std::mutex              _mtxExceptions;
-    std::condition_variable _cv;
-    bool                    _stop;
+    Placement                             _placement;
+    std::string                           _name;
+    std::chrono::milliseconds             _tick;
+    WaitPolicy                            _wait;
+    std::chrono::steady_clock::time_point _epoch;
 
-    std::chrono::milliseconds _tick;
+    uint64_t   currentTick() const;
+    uint64_t   ticks(std::chrono::milliseconds duration) const;
+    void       run(Task& task);
+    uint64_t   following(Task& task, uint64_t now);
+    void       check(const TaskOptions& options) const;
+    Task*      make(const std::function<void()>& func, const TaskOptions& options);
+    Task*      acquire();
+    TaskHandle add(Task* task, size_t shard);
+    Task*      find(TaskHandle handle);
+    Task&      get(TaskHandle handle);
+    void       erase(Task& task);
+    void       reclaim();
 
-    void runtime();
+    size_t choose(size_t key) const;
+    void   attach(Task* task);
+    void   detach(Task& task);
+    void   rebalance();
+    void   wake(Shard& shard);
+    void   apply(Shard& shard);
+    void   push(std::atomic<Task*>& list, Task* task, Task* Task::*link);
+    void   sleep(Shard& shard);
+    void   runtime(size_t index);
 
 public:
-    PersistentWorker(std::chrono::milliseconds tick = std::chrono::milliseconds(1));
+    PersistentWorker(std::chrono::milliseconds tick = std::chrono::milliseconds(1),
+                     const WaitPolicy&         wait = WaitPolicy());
+    explicit PersistentWorker(const Options& options);
     ~PersistentWorker();
 
-    void addTask(const std::string& name, const std::function<void()>& func);
+    PersistentWorker(const PersistentWorker&)            = delete;
+    PersistentWorker& operator=(const PersistentWorker&) = delete;
+
+    /**
+     * @brief Schedule %func and return the handle that identifies it from then on.
+     * @throw std::out_of_range if %options names a shard that does not exist.
+     */
+    TaskHandle addTask(const std::function<void()>& func, const TaskOptions& options);
+    TaskHandle addTask(const std::function<void()>& func);
+
+    /**
+     * @return false if %handle is stale.
+     * @warning A run already in progress is not interrupted.
+     */
+    bool removeTask(TaskHandle handle);
+
+    /**
+     * @brief Run %func every tick, starting right away. Replaces a task of the same name.
+     */
+    TaskHandle addTask(const std::string& name, const std::function<void()>& func);
+
+    /**
+     * @brief Run %func every %interval, the first time after %delay.
+     */
+    TaskHandle addTask(const std::string&           name,
+                       const std::function<void()>& func,
+                       std::chrono::milliseconds    interval,
+                       std::chrono::milliseconds    delay = std::chrono::milliseconds(0));
+
+    TaskHandle addTask(const std::string&           name,
+                       const std::function<void()>& func,
+                       const TaskOptions&           options);
 
     /**
      * @brief Remove a task by its name.
      * @param name The name of the task to be removed.
-     * @warning If the task is already in copy vector, it will still be executed one last time
-     * before being removed.
+     * @warning A run already in progress is not interrupted.
      */
     void removeTask(const std::string& name);
 
     std::vector<std::exception_ptr> getExceptions();
+
+    /**
+     * @throw std::out_of_range for an unknown task or a stale handle.
+     */
+    TaskStats taskStats(TaskHandle handle);
+    TaskStats taskStats(const std::string& name);
+
+    /**
+     * @brief Shard currently running the task.
+     * @throw std::out_of_range for an unknown task or a stale handle.
+     */
+    size_t shardOf(TaskHandle handle);
+    size_t shardOf(const std::string& name);
+
+    size_t threadCount() const;
+
+    /**
+     * @brief CPU time and context switches of each shard thread, sampled now.
+     */
+    std::vector<ThreadStats> threadStats() const;
 };
 
 #endif // !_PERSISTENT_WORKER_HPP
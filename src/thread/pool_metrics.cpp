@@ -0,0 +1,161 @@
+#include "pool_metrics.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <chrono>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <sstream>
+#include <string>
+
+size_t LatencyHistogram::bucketOf(uint64_t value)
+{
+    constexpr uint64_t SUB = uint64_t(1) << SUB_BITS;
+
+    value = std::min(value, (uint64_t(1) << MAX_BITS) - 1);
+    if (value < SUB)
+        return value;
+
+    // The SUB_BITS bits below the most significant one pick the bucket within its power of 2.
+    unsigned exponent = std::bit_width(value) - 1;
+    uint64_t top      = value >> (exponent - SUB_BITS);
+    return (exponent - SUB_BITS + 1) * SUB + (top - SUB);
+}
+
+uint64_t LatencyHistogram::bucketUpperBound(size_t bucket)
+{
+    constexpr uint64_t SUB = uint64_t(1) << SUB_BITS;
+
+    if (bucket < SUB)
+        return bucket;
+    uint64_t group = bucket / SUB;
+    uint64_t top   = bucket % SUB + SUB;
+    unsigned shift = static_cast<unsigned>(group - 1);
+    return ((top + 1) << shift) - 1;
+}
+
+void LatencyHistogram::record(uint64_t value)
+{
+    _buckets[bucketOf(value)]++;
+    _count++;
+    _total += value;
+    _max = std::max(_max, value);
+}
+
+void LatencyHistogram::merge(const LatencyHistogram& other)
+{
+    for (size_t i = 0; i < BUCKETS; ++i)
+        _buckets[i] += other._buckets[i];
+    _count += other._count;
+    _total += other._total;
+    _max = std::max(_max, other._max);
+}
+
+uint64_t LatencyHistogram::count() const
+{
+    return _count;
+}
+
+std::chrono::nanoseconds LatencyHistogram::total() const
+{
+    return std::chrono::nanoseconds(_total);
+}
+
+std::chrono::nanoseconds LatencyHistogram::mean() const
+{
+    return std::chrono::nanoseconds(_count == 0 ? 0 : _total / _count);
+}
+
+std::chrono::nanoseconds LatencyHistogram::max() const
+{
+    return std::chrono::nanoseconds(_max);
+}
+
+std::chrono::nanoseconds LatencyHistogram::percentile(double quantile) const
+{
+    if (_count == 0)
+        return std::chrono::nanoseconds(0);
+
+    auto     rank = static_cast<uint64_t>(std::ceil(quantile * static_cast<double>(_count)));
+    uint64_t seen = 0;
+    rank          = std::clamp<uint64_t>(rank, 1, _count);
+    for (size_t i = 0; i < BUCKETS; ++i)
+    {
+        seen += _buckets[i];
+        if (seen >= rank)
+            return std::chrono::nanoseconds(std::min(bucketUpperBound(i), _max));
+    }
+    return max();
+}
+
+void ConcurrentLatencyHistogram::record(uint64_t value)
+{
+    _buckets[LatencyHistogram::bucketOf(value)].fetch_add(1, std::memory_order_relaxed);
+    _count.fetch_add(1, std::memory_order_relaxed);
+    _total.fetch_add(value, std::memory_order_relaxed);
+
+    uint64_t max = _max.load(std::memory_order_relaxed);
+    while (value > max && !_max.compare_exchange_weak(max, value, std::memory_order_relaxed))
+    {
+    }
+}
+
+LatencyHistogram ConcurrentLatencyHistogram::snapshot() const
+{
+    LatencyHistogram result;
+    for (size_t i = 0; i < LatencyHistogram::BUCKETS; ++i)
+        result._buckets[i] = _buckets[i].load(std::memory_order_relaxed);
+    result._count = _count.load(std::memory_order_relaxed);
+    result._total = _total.load(std::memory_order_relaxed);
+    result._max   = _max.load(std::memory_order_relaxed);
+    return result;
+}
+
+double PoolMetricsSnapshot::Worker::utilization() const
+{
+    auto active = busy + idle;
+    return active.count() == 0 ? 0.0 : static_cast<double>(busy.count()) / active.count();
+}
+
+double PoolMetricsSnapshot::throughput() const
+{
+    double seconds = std::chrono::duration<double>(elapsed).count();
+    return seconds == 0 ? 0.0 : static_cast<double>(jobsCompleted) / seconds;
+}
+
+namespace
+{
+void writeHistogram(std::ostringstream& out, const LatencyHistogram& histogram)
+{
+    out << "{\"count\":" << histogram.count() << ",\"mean_ns\":" << histogram.mean().count()
+        << ",\"p50_ns\":" << histogram.percentile(0.5).count()
+        << ",\"p90_ns\":" << histogram.percentile(0.9).count()
+        << ",\"p99_ns\":" << histogram.percentile(0.99).count()
+        << ",\"p999_ns\":" << histogram.percentile(0.999).count()
+        << ",\"max_ns\":" << histogram.max().count() << "}";
+}
+} // namespace
+
+std::string PoolMetricsSnapshot::toJson() const
+{
+    std::ostringstream out;
+    out << "{\"enabled\":" << (enabled ? "true" : "false")
+        << ",\"elapsed_ns\":" << elapsed.count() << ",\"jobs_completed\":" << jobsCompleted
+        << ",\"jobs_failed\":" << jobsFailed << ",\"jobs_pending\":" << jobsPending
+        << ",\"throughput\":" << throughput() << ",\"queue_wait\":";
+    writeHistogram(out, queueWait);
+    out << ",\"execution\":";
+    writeHistogram(out, execution);
+    out << ",\"workers\":[";
+    for (size_t i = 0; i < workers.size(); ++i)
+    {
+        out << (i ? "," : "") << "{\"jobs\":" << workers[i].jobs
+            << ",\"busy_ns\":" << workers[i].busy.count()
+            << ",\"idle_ns\":" << workers[i].idle.count()
+            << ",\"utilization\":" << workers[i].utilization() << "}";
+    }
+    out << "]}";
+    return out.str();
+}
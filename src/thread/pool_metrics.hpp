@@ -0,0 +1,103 @@
+#ifndef _POOL_METRICS_HPP_
+#define _POOL_METRICS_HPP_
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/**
+ * @brief Log-linear latency histogram in nanoseconds, in the spirit of HdrHistogram.
+ *
+ * Each power of two is split in 2^SUB_BITS buckets, so any recorded value is known within
+ * about 3% while the whole range up to 2^MAX_BITS ns (about 18 minutes) fits in a fixed array.
+ * Larger values are clamped. Histograms of several threads merge by adding their buckets.
+ */
+class LatencyHistogram
+{
+public:
+    static constexpr unsigned SUB_BITS = 5;
+    static constexpr unsigned MAX_BITS = 40;
+    static constexpr size_t   BUCKETS  = (MAX_BITS - SUB_BITS + 1) << SUB_BITS;
+
+    static size_t   bucketOf(uint64_t value);
+    static uint64_t bucketUpperBound(size_t bucket);
+
+    void record(uint64_t value);
+    void merge(const LatencyHistogram& other);
+
+    uint64_t                 count() const;
+    std::chrono::nanoseconds total() const;
+    std::chrono::nanoseconds mean() const;
+    std::chrono::nanoseconds max() const;
+
+    /**
+     * @brief Smallest bucket bound that at least %quantile (0 to 1) of the values are below.
+     */
+    std::chrono::nanoseconds percentile(double quantile) const;
+
+private:
+    friend class ConcurrentLatencyHistogram;
+
+    std::array<uint64_t, BUCKETS> _buckets{};
+    uint64_t                      _count = 0;
+    uint64_t                      _total = 0;
+    uint64_t                      _max   = 0;
+};
+
+/**
+ * @brief LatencyHistogram recorded without locks and read at any time through snapshot().
+ *
+ * Meant to be owned by one recording thread, so the relaxed increments never contend; a
+ * snapshot taken during recording may be off by the values being recorded.
+ */
+class ConcurrentLatencyHistogram
+{
+public:
+    void             record(uint64_t value);
+    LatencyHistogram snapshot() const;
+
+private:
+    std::array<std::atomic<uint64_t>, LatencyHistogram::BUCKETS> _buckets{};
+    std::atomic<uint64_t>                                        _count{0};
+    std::atomic<uint64_t>                                        _total{0};
+    std::atomic<uint64_t>                                        _max{0};
+};
+
+/**
+ * @brief State of a WorkerPool's instrumentation at one point in time.
+ */
+struct PoolMetricsSnapshot
+{
+    struct Worker
+    {
+        uint64_t                 jobs = 0;
+        std::chrono::nanoseconds busy{0};
+        std::chrono::nanoseconds idle{0};
+
+        /** busy / (busy + idle), or 0 before the first job. */
+        double utilization() const;
+    };
+
+    /** False when the pool does not record metrics; everything else is then empty. */
+    bool                     enabled = false;
+    std::chrono::nanoseconds elapsed{0};
+    uint64_t                 jobsCompleted = 0;
+    uint64_t                 jobsFailed    = 0;
+    uint64_t                 jobsPending   = 0;
+    LatencyHistogram         queueWait;
+    LatencyHistogram         execution;
+    /** One entry per worker slot; jobs run by other threads through runPendingJob() are not
+     * attributed to a worker but are part of the totals and histograms. */
+    std::vector<Worker> workers;
+
+    /** Completed jobs per second since the pool started. */
+    double throughput() const;
+
+    std::string toJson() const;
+};
+
+#endif // !_POOL_METRICS_HPP_
@@ -0,0 +1,58 @@
+#ifndef _SPIN_WAIT_HPP_
+#define _SPIN_WAIT_HPP_
+
+#include <thread>
+
+/**
+ * @brief Budgets of the spin and yield phases a waiter goes through before parking.
+ *
+ * A handoff that arrives while the waiter still spins costs no syscall on either side. Both
+ * budgets at 0 park immediately.
+ */
+struct WaitPolicy
+{
+    /** Polls separated by a CPU pause hint; skipped on a single-CPU machine. */
+    unsigned spins = 128;
+    /** Polls separated by std::this_thread::yield(). */
+    unsigned yields = 8;
+};
+
+inline void cpuRelax()
+{
+#if defined(__x86_64__) || defined(__i386__)
+    __builtin_ia32_pause();
+#elif defined(__aarch64__) || defined(__arm__)
+    asm volatile("yield" ::: "memory");
+#endif
+}
+
+/**
+ * @brief Poll %ready through the spin then yield phases of %policy.
+ * @return true as soon as %ready does, false once the budget is spent and the caller should
+ * park.
+ */
+template <typename TReady>
+bool spinUntil(const WaitPolicy& policy, TReady&& ready)
+{
+    // Spinning on the only CPU just delays the thread we are waiting for.
+    static const bool singleCpu = std::thread::hardware_concurrency() <= 1;
+
+    if (!singleCpu)
+    {
+        for (unsigned i = 0; i < policy.spins; ++i)
+        {
+            if (ready())
+                return true;
+            cpuRelax();
+        }
+    }
+    for (unsigned i = 0; i < policy.yields; ++i)
+    {
+        if (ready())
+            return true;
+        std::this_thread::yield();
+    }
+    return ready();
+}
+
+#endif // !_SPIN_WAIT_HPP_
@@ -0,0 +1,156 @@
+#include "task_graph.hpp"
+
+#include <atomic>
+#include <cstddef>
+#include <exception>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+TaskGraph::TaskGraph() : _dirty(false), _running(false), _pool(nullptr), _failed(false) {}
+
+TaskGraph::~TaskGraph() {}
+
+TaskGraph::NodeId TaskGraph::addNode(InlineFunction<void()> func, const std::string& name)
+{
+    auto node   = std::make_unique<Node>();
+    node->graph = this;
+    node->func  = std::move(func);
+    node->name  = name;
+    node->index = _nodes.size();
+    _nodes.push_back(std::move(node));
+    _dirty = true;
+    return _nodes.size() - 1;
+}
+
+void TaskGraph::precede(NodeId before, NodeId after)
+{
+    if (before >= _nodes.size() || after >= _nodes.size())
+        throw std::out_of_range("TaskGraph: unknown node");
+    _nodes[before]->successors.push_back(_nodes[after].get());
+    _nodes[after]->predecessors++;
+    _dirty = true;
+}
+
+size_t TaskGraph::size() const
+{
+    return _nodes.size();
+}
+
+const std::string& TaskGraph::name(NodeId node) const
+{
+    return _nodes.at(node)->name;
+}
+
+void TaskGraph::validate()
+{
+    // Kahn's algorithm: every node must be reachable by peeling off nodes with no predecessor.
+    std::vector<size_t> indegree(_nodes.size());
+    std::vector<Node*>  ready;
+    for (size_t i = 0; i < _nodes.size(); ++i)
+    {
+        indegree[i] = _nodes[i]->predecessors;
+        if (indegree[i] == 0)
+            ready.push_back(_nodes[i].get());
+    }
+    _roots = ready;
+
+    size_t visited = 0;
+    while (!ready.empty())
+    {
+        Node* node = ready.back();
+        ready.pop_back();
+        ++visited;
+        for (Node* succ : node->successors)
+        {
+            if (--indegree[succ->index] == 0)
+                ready.push_back(succ);
+        }
+    }
+    if (visited != _nodes.size())
+        throw std::logic_error("TaskGraph contains a cycle");
+    _dirty = false;
+}
+
+void TaskGraph::run(WorkerPool& pool)
+{
+    if (_running.exchange(true))
+        throw std::logic_error("TaskGraph is already running");
+
+    try
+    {
+        if (_dirty)
+            validate();
+    }
+    catch (...)
+    {
+        _running.store(false);
+        throw;
+    }
+
+    if (_nodes.empty())
+    {
+        _running.store(false);
+        return;
+    }
+
+    _pool = &pool;
+    _failed.store(false, std::memory_order_relaxed);
+    _exception = nullptr;
+    for (auto& node : _nodes)
+    {
+        node->pending.store(node->predecessors, std::memory_order_relaxed);
+        node->skipped.store(false, std::memory_order_relaxed);
+    }
+    _done.reset(static_cast<ptrdiff_t>(_nodes.size()));
+
+    for (Node* root : _roots)
+        pool.addJob(root);
+
+    while (!_done.tryWait())
+    {
+        if (!pool.runPendingJob())
+        {
+            _done.wait();
+            break;
+        }
+    }
+
+    std::exception_ptr exception = _exception;
+    _running.store(false);
+    if (exception)
+        std::rethrow_exception(exception);
+}
+
+void TaskGraph::Node::execute()
+{
+    if (!skipped.load(std::memory_order_acquire))
+    {
+        try
+        {
+            func();
+        }
+        catch (...)
+        {
+            if (!graph->_failed.exchange(true))
+                graph->_exception = std::current_exception();
+            skipped.store(true, std::memory_order_relaxed);
+        }
+    }
+    graph->finish(*this);
+}
+
+void TaskGraph::finish(Node& node)
+{
+    bool skip = node.skipped.load(std::memory_order_relaxed);
+    for (Node* succ : node.successors)
+    {
+        if (skip)
+            succ->skipped.store(true, std::memory_order_relaxed);
+        if (succ->pending.fetch_sub(1, std::memory_order_acq_rel) == 1)
+            _pool->addJob(succ);
+    }
+    // Last access to the graph from this node: run() may return right after.
+    _done.countDown();
+}
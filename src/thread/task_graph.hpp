@@ -0,0 +1,83 @@
+#ifndef _TASK_GRAPH_HPP_
+#define _TASK_GRAPH_HPP_
+
+#include <atomic>
+#include <cstddef>
+#include <exception>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "inline_function.hpp"
+#include "latch.hpp"
+#include "worker_pool.hpp"
+
+/**
+ * @brief Dependency graph of tasks executed on a WorkerPool.
+ *
+ * Each node keeps an atomic count of unfinished predecessors; the predecessor that brings it to
+ * zero queues it, so no lock or central scheduler sits between stages. The graph is built once
+ * and can be run any number of times: a run only resets the counters.
+ */
+class TaskGraph
+{
+public:
+    using NodeId = size_t;
+
+    TaskGraph();
+    ~TaskGraph();
+
+    TaskGraph(const TaskGraph&)            = delete;
+    TaskGraph& operator=(const TaskGraph&) = delete;
+
+    NodeId addNode(InlineFunction<void()> func, const std::string& name = "");
+
+    /**
+     * @brief Make %after wait for %before.
+     * @throw std::out_of_range on an unknown node.
+     */
+    void precede(NodeId before, NodeId after);
+
+    /**
+     * @brief Execute every node once, respecting the edges, and return when all are done.
+     *
+     * The calling thread runs queued pool jobs while it waits. If a node throws, its
+     * successors are skipped and the first exception is rethrown here once the run drains.
+     * @throw std::logic_error if the graph has a cycle or is already running.
+     */
+    void run(WorkerPool& pool);
+
+    size_t             size() const;
+    const std::string& name(NodeId node) const;
+
+private:
+    class Node : public WorkerPool::IJob
+    {
+    public:
+        TaskGraph*             graph;
+        InlineFunction<void()> func;
+        std::string            name;
+        NodeId                 index;
+        std::vector<Node*>     successors;
+        size_t                 predecessors = 0;
+        std::atomic<size_t>    pending;
+        std::atomic<bool>      skipped;
+
+        void execute() override;
+    };
+
+    std::vector<std::unique_ptr<Node>> _nodes;
+    std::vector<Node*>                 _roots;
+    bool                               _dirty;
+    std::atomic<bool>                  _running;
+
+    WorkerPool*        _pool;
+    Latch              _done;
+    std::atomic<bool>  _failed;
+    std::exception_ptr _exception;
+
+    void validate();
+    void finish(Node& node);
+};
+
+#endif // !_TASK_GRAPH_HPP_
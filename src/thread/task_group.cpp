@@ -0,0 +1,89 @@
+#include "task_group.hpp"
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <mutex>
+#include <utility>
+
+namespace
+{
+// Waiters sleep on this counter rather than on a member of their group: the job that finishes a
+// group must not touch it once wait() may have returned and destroyed it.
+std::atomic<uint32_t> finishedGroups(0);
+} // namespace
+
+TaskGroup::TaskGroup(WorkerPool& pool, CancellationToken parent)
+    : _pool(pool), _parent(std::move(parent)), _source(_parent), _pending(0)
+{
+}
+
+TaskGroup::~TaskGroup()
+{
+    join();
+}
+
+void TaskGroup::join()
+{
+    while (true)
+    {
+        // Read before _pending: a group finishing in between bumps it and the wait returns.
+        uint32_t finished = finishedGroups.load();
+        if (_pending.load() == 0)
+            return;
+        if (!_pool.runPendingJob())
+            finishedGroups.wait(finished);
+    }
+}
+
+void TaskGroup::wait()
+{
+    join();
+
+    std::exception_ptr exception;
+    {
+        std::lock_guard<std::mutex> lock(_mtx);
+        exception = std::exchange(_exception, nullptr);
+    }
+    // No job of the group runs any more: the next batch starts with a fresh source.
+    if (_source.isCancelled())
+        _source = CancellationSource(_parent);
+    if (exception)
+        std::rethrow_exception(exception);
+}
+
+void TaskGroup::cancel()
+{
+    _source.cancel();
+}
+
+bool TaskGroup::isCancelled() const
+{
+    return _source.isCancelled();
+}
+
+CancellationToken TaskGroup::token() const
+{
+    return _source.token();
+}
+
+void TaskGroup::fail(std::exception_ptr exception)
+{
+    {
+        std::lock_guard<std::mutex> lock(_mtx);
+        if (!_exception)
+            _exception = exception;
+    }
+    _source.cancel();
+}
+
+void TaskGroup::finish()
+{
+    // Last access to the group from a job: wait() may return right after.
+    if (_pending.fetch_sub(1) == 1)
+    {
+        finishedGroups.fetch_add(1);
+        finishedGroups.notify_all();
+    }
+}
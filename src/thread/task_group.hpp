@@ -0,0 +1,102 @@
+#ifndef _TASK_GROUP_HPP_
+#define _TASK_GROUP_HPP_
+
+#include <atomic>
+#include <cstddef>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <type_traits>
+#include <utility>
+
+#include "cancellation.hpp"
+#include "worker_pool.hpp"
+
+/**
+ * @brief Set of jobs on a shared WorkerPool that can be waited on and cancelled together.
+ *
+ * wait() only waits for this group's jobs, so one long-lived pool can serve many batches. Jobs
+ * still queued when the group is cancelled are skipped; running ones see it through the token
+ * they may take as argument. The first exception thrown by a job cancels the group and is
+ * rethrown by wait().
+ */
+class TaskGroup
+{
+public:
+    /**
+     * @param %parent Cancelling it also cancels this group.
+     */
+    explicit TaskGroup(WorkerPool& pool, CancellationToken parent = CancellationToken());
+
+    /**
+     * @brief Waits for the remaining jobs, dropping their exceptions.
+     */
+    ~TaskGroup();
+
+    TaskGroup(const TaskGroup&)            = delete;
+    TaskGroup& operator=(const TaskGroup&) = delete;
+
+    /**
+     * @brief Queue %func() on the pool, or %func(token) if it takes a CancellationToken.
+     */
+    template <typename TFunc>
+    void run(TFunc&& func);
+
+    /**
+     * @brief Return once every job run so far has finished or been skipped.
+     *
+     * The calling thread runs pool jobs while it waits. The group can be reused afterwards: a
+     * failure or cancel() only concerns the jobs run before this call, so the group is no
+     * longer cancelled once it returns, unless its parent is.
+     * @warning run() from another thread must not overlap wait().
+     * @throw The first exception thrown by a job since the last wait(), other than
+     * OperationCancelled.
+     */
+    void wait();
+
+    void              cancel();
+    bool              isCancelled() const;
+    CancellationToken token() const;
+
+private:
+    WorkerPool&         _pool;
+    CancellationToken   _parent;
+    CancellationSource  _source;
+    std::atomic<size_t> _pending;
+    std::mutex          _mtx;
+    std::exception_ptr  _exception;
+
+    void join();
+    void fail(std::exception_ptr exception);
+    void finish();
+};
+
+template <typename TFunc>
+void TaskGroup::run(TFunc&& func)
+{
+    _pending.fetch_add(1, std::memory_order_relaxed);
+    _pool.submit(
+        [this, func = std::forward<TFunc>(func)]() mutable
+        {
+            if (!isCancelled())
+            {
+                try
+                {
+                    if constexpr (std::is_invocable_v<std::decay_t<TFunc>&, CancellationToken>)
+                        std::invoke(func, token());
+                    else
+                        std::invoke(func);
+                }
+                catch (const OperationCancelled&)
+                {
+                }
+                catch (...)
+                {
+                    fail(std::current_exception());
+                }
+            }
+            finish();
+        });
+}
+
+#endif // !_TASK_GROUP_HPP_
@@ -1,30 +1,181 @@
 #include "thread.hpp"
 
+#include <pthread.h>
+#include <sched.h>
+#include <sys/resource.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <climits>
 #include <functional>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <stop_token>
 #include <string>
-#include <thread>
+#include <system_error>
+#include <vector>
 
+#include "scratch_arena.hpp"
 #include "thread_safe_iostream.hpp"
+#include "thread_stats.hpp"
+
+namespace
+{
+thread_local ScratchArena* currentScratch = nullptr;
+} // namespace
 
 Thread::Thread(const std::string& name, std::function<void()> func)
-    : _name(name), _func(std::move(func))
+    : Thread(name, [func = std::move(func)](std::stop_token) { func(); })
+{
+}
+
+Thread::Thread(const std::string& name, std::function<void(std::stop_token)> func)
+    : Thread(name, std::move(func), Options())
+{
+}
+
+Thread::Thread(const std::string&                   name,
+               std::function<void(std::stop_token)> func,
+               const Options&                       options)
+    : _name(name), _thread(), _joinable(false), _func(std::move(func)), _repeat(options.repeat),
+      _attributes(options), _scheduling(Scheduling::Normal)
 {
+    if (options.scratchSize)
+        _scratch = std::make_unique<ScratchArena>(options.scratchSize);
+}
+
+Thread::~Thread()
+{
+    stop();
 }
 
 void Thread::start()
 {
-    _thread = std::thread(
-        [this]
-        {
-            ThreadSafeIO.setPrefix(_name);
-            _func();
-        });
+    if (_joinable)
+        throw std::logic_error("Thread::start: already running");
+
+    // std::thread cannot take a stack size, hence pthread_create.
+    pthread_attr_t attr;
+    pthread_attr_init(&attr);
+    if (_attributes.stackSize)
+    {
+        size_t size = std::max<size_t>(_attributes.stackSize, PTHREAD_STACK_MIN);
+        pthread_attr_setstacksize(&attr, size);
+    }
+
+    _stopSource = std::stop_source();
+    int error   = pthread_create(&_thread, &attr, &Thread::entry, this);
+    pthread_attr_destroy(&attr);
+    if (error)
+        throw std::system_error(error, std::generic_category(), "Thread::start");
+    _joinable = true;
 }
 
 void Thread::stop()
 {
-    if (_thread.joinable())
+    if (_joinable)
+    {
+        _stopSource.request_stop();
+        pthread_join(_thread, nullptr);
+        _joinable = false;
+    }
+}
+
+void* Thread::entry(void* self) noexcept
+{
+    static_cast<Thread*>(self)->run();
+    return nullptr;
+}
+
+void Thread::run()
+{
+    applyAttributes();
+    ThreadRegistry::Scope registration(_name, this);
+    ThreadSafeIO.setPrefix(_name);
+    currentScratch        = _scratch.get();
+    std::stop_token token = _stopSource.get_token();
+    if (!_repeat)
+        _func(token);
+    while (_repeat && !token.stop_requested())
+    {
+        _func(token);
+        if (_scratch)
+            _scratch->reset();
+    }
+    currentScratch = nullptr;
+
+    std::lock_guard<std::mutex> lock(_statsMutex);
+    _lastStats         = registration.stats();
+    _lastStats.running = false;
+}
+
+void Thread::applyAttributes()
+{
+    if (!_attributes.osName.empty())
+    {
+        std::string name = _attributes.osName.substr(0, 15);
+        pthread_setname_np(pthread_self(), name.c_str());
+    }
+
+    if (!_attributes.cpus.empty())
     {
-        _thread.join();
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        for (int cpu : _attributes.cpus)
+        {
+            if (cpu >= 0 && cpu < CPU_SETSIZE)
+                CPU_SET(cpu, &set);
+        }
+        pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+    }
+
+    // Real-time policies need CAP_SYS_NICE or an RLIMIT_RTPRIO; without them the thread keeps
+    // the normal policy and the nice value below is what is left to favour it.
+    Scheduling scheduling = Scheduling::Normal;
+    if (_attributes.scheduling != Scheduling::Normal)
+    {
+        int         policy = _attributes.scheduling == Scheduling::Fifo ? SCHED_FIFO : SCHED_RR;
+        sched_param param{};
+        param.sched_priority = std::clamp(_attributes.priority, sched_get_priority_min(policy),
+                                          sched_get_priority_max(policy));
+        if (pthread_setschedparam(pthread_self(), policy, &param) == 0)
+            scheduling = _attributes.scheduling;
     }
+    _scheduling.store(scheduling);
+
+    // On Linux the nice value belongs to the thread, not the process.
+    if (_attributes.nice)
+        setpriority(PRIO_PROCESS, static_cast<id_t>(gettid()), *_attributes.nice);
+}
+
+bool Thread::requestStop()
+{
+    return _stopSource.request_stop();
+}
+
+std::stop_token Thread::stopToken() const
+{
+    return _stopSource.get_token();
+}
+
+Thread::Scheduling Thread::scheduling() const
+{
+    return _scheduling.load();
+}
+
+ThreadStats Thread::stats() const
+{
+    std::vector<ThreadStats> live = ThreadRegistry::instance().snapshot(this);
+    if (!live.empty())
+        return live.front();
+    std::lock_guard<std::mutex> lock(_statsMutex);
+    return _lastStats;
+}
+
+ScratchArena& Thread::scratch()
+{
+    if (!currentScratch)
+        throw std::logic_error("Thread::scratch: no scratch arena on this thread");
+    return *currentScratch;
 }
@@ -1,23 +1,131 @@
 #ifndef _THREAD_HPP
 #define _THREAD_HPP
 
+#include <pthread.h>
+
+#include <atomic>
+#include <cstddef>
 #include <functional>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <stop_token>
 #include <string>
-#include <thread>
+#include <vector>
 
+#include "scratch_arena.hpp"
 #include "thread_safe_iostream.hpp"
+#include "thread_stats.hpp"
 
 class Thread
 {
+public:
+    enum class Scheduling
+    {
+        Normal,
+        Fifo,
+        RoundRobin,
+    };
+
+    struct Options
+    {
+        /** Call the function again and again until a stop is requested. */
+        bool repeat = false;
+        /** Initial size of the thread's scratch() arena; 0 means none. It is reset after every
+         * repetition and grows to what one needs. */
+        size_t scratchSize = 0;
+
+        /** CPUs the thread may run on; empty leaves the inherited mask. */
+        std::vector<int> cpus{};
+        /** Nice value, -20 (favoured) to 19; lowering it needs CAP_SYS_NICE. */
+        std::optional<int> nice{};
+        /** Real-time policy. Without the right to use it the thread stays Normal; see
+         * scheduling(). */
+        Scheduling scheduling = Scheduling::Normal;
+        /** Real-time priority, 1 to 99, for Fifo and RoundRobin. */
+        int priority = 1;
+        /** 0 keeps the system default; smaller values are raised to PTHREAD_STACK_MIN. */
+        size_t stackSize = 0;
+        /** Name shown by ps and debuggers, cut to 15 characters; empty keeps the inherited
+         * one. */
+        std::string osName{};
+    };
+
 private:
-    std::string           _name;
-    std::thread           _thread;
-    std::function<void()> _func;
+    std::string                          _name;
+    pthread_t                            _thread;
+    bool                                 _joinable;
+    std::function<void(std::stop_token)> _func;
+    std::stop_source                     _stopSource;
+    bool                                 _repeat;
+    std::unique_ptr<ScratchArena>        _scratch;
+    Options                              _attributes;
+    std::atomic<Scheduling>              _scheduling;
+    mutable std::mutex                   _statsMutex;
+    ThreadStats                          _lastStats;
+
+    static void* entry(void* self) noexcept;
+    void         run();
+    void         applyAttributes();
 
 public:
     Thread(const std::string& name, std::function<void()> func);
+
+    /**
+     * @brief Like std::jthread, pass the function a token that reports stop requests.
+     */
+    Thread(const std::string& name, std::function<void(std::stop_token)> func);
+    Thread(const std::string&                   name,
+           std::function<void(std::stop_token)> func,
+           const Options&                       options);
+
+    /**
+     * @brief Request a stop and join, like the destructor of std::jthread.
+     */
+    ~Thread();
+
+    Thread(const Thread&)            = delete;
+    Thread& operator=(const Thread&) = delete;
+
+    /**
+     * @brief Create the thread; its attributes are in place before the function is called.
+     *
+     * Affinity, nice value and policy are best effort: one the system refuses is skipped and
+     * the function runs anyway.
+     * @throw std::system_error if the thread cannot be created.
+     * @throw std::logic_error if it is already running.
+     */
     void start();
+
+    /**
+     * @brief Request a stop, then wait for the function to return.
+     */
     void stop();
+
+    /**
+     * @return false if a stop was already requested.
+     */
+    bool requestStop();
+
+    std::stop_token stopToken() const;
+
+    /**
+     * @brief Policy the thread actually got: Normal when the real-time one was refused.
+     * @note Meaningful once the function runs.
+     */
+    Scheduling scheduling() const;
+
+    /**
+     * @brief CPU time, context switches and wall time of the thread: live while it runs, as it
+     * was when the function returned afterwards.
+     */
+    ThreadStats stats() const;
+
+    /**
+     * @brief Scratch arena of the calling Thread.
+     * @throw std::logic_error outside a Thread started with a scratchSize.
+     */
+    static ScratchArena& scratch();
 };
 
 #endif // !_THREAD_HPP
@@ -0,0 +1,182 @@
+#include "thread_stats.hpp"
+
+#include <pthread.h>
+#include <sys/resource.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <fstream>
+#include <iomanip>
+#include <mutex>
+#include <ostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace
+{
+std::chrono::nanoseconds cpuTime(clockid_t clock)
+{
+    timespec time{};
+    if (clock_gettime(clock, &time) != 0)
+        return std::chrono::nanoseconds(0);
+    return std::chrono::seconds(time.tv_sec) + std::chrono::nanoseconds(time.tv_nsec);
+}
+
+// getrusage(RUSAGE_THREAD) only answers for the caller; the kernel shows the others here.
+void readSwitches(pid_t tid, ThreadStats& stats)
+{
+    std::ifstream status("/proc/self/task/" + std::to_string(tid) + "/status");
+    std::string   line;
+    while (std::getline(status, line))
+    {
+        if (line.starts_with("voluntary_ctxt_switches:"))
+            stats.voluntarySwitches = std::stoull(line.substr(line.find(':') + 1));
+        else if (line.starts_with("nonvoluntary_ctxt_switches:"))
+            stats.involuntarySwitches = std::stoull(line.substr(line.find(':') + 1));
+    }
+}
+
+void writeEscaped(std::ostream& out, const std::string& text)
+{
+    out << '"';
+    for (char c : text)
+    {
+        if (c == '"' || c == '\\')
+            out << '\\' << c;
+        else if (static_cast<unsigned char>(c) < 0x20)
+            out << ' ';
+        else
+            out << c;
+    }
+    out << '"';
+}
+} // namespace
+
+double ThreadStats::cpuShare() const
+{
+    return wall.count() ? static_cast<double>(cpu.count()) / wall.count() : 0.0;
+}
+
+ThreadStats ThreadStats::current()
+{
+    ThreadStats stats;
+    stats.tid     = gettid();
+    stats.cpu     = cpuTime(CLOCK_THREAD_CPUTIME_ID);
+    stats.running = true;
+
+    rusage usage{};
+    if (getrusage(RUSAGE_THREAD, &usage) == 0)
+    {
+        stats.voluntarySwitches   = usage.ru_nvcsw;
+        stats.involuntarySwitches = usage.ru_nivcsw;
+    }
+    return stats;
+}
+
+ThreadRegistry::Scope::Scope(const std::string& name, const void* owner)
+    : _name(name), _owner(owner), _tid(gettid()), _clock(CLOCK_THREAD_CPUTIME_ID),
+      _start(std::chrono::steady_clock::now())
+{
+    pthread_getcpuclockid(pthread_self(), &_clock);
+
+    ThreadRegistry&             registry = instance();
+    std::lock_guard<std::mutex> lock(registry._mutex);
+    registry._scopes.push_back(this);
+}
+
+ThreadRegistry::Scope::~Scope()
+{
+    ThreadRegistry&             registry = instance();
+    std::lock_guard<std::mutex> lock(registry._mutex);
+    std::erase(registry._scopes, this);
+}
+
+ThreadStats ThreadRegistry::Scope::stats() const
+{
+    ThreadStats stats = ThreadStats::current();
+    stats.name        = _name;
+    stats.wall        = std::chrono::steady_clock::now() - _start;
+    return stats;
+}
+
+ThreadRegistry& ThreadRegistry::instance()
+{
+    static ThreadRegistry registry;
+    return registry;
+}
+
+std::vector<ThreadStats> ThreadRegistry::snapshot()
+{
+    return collect(nullptr, true);
+}
+
+std::vector<ThreadStats> ThreadRegistry::snapshot(const void* owner)
+{
+    return collect(owner, false);
+}
+
+void ThreadRegistry::dump(std::ostream& out)
+{
+    for (const ThreadStats& stats : snapshot())
+    {
+        out << std::setw(24) << std::left << stats.name << std::right << " tid "
+            << std::setw(7) << stats.tid << " cpu "
+            << std::chrono::duration_cast<std::chrono::microseconds>(stats.cpu).count()
+            << "us wall "
+            << std::chrono::duration_cast<std::chrono::microseconds>(stats.wall).count()
+            << "us share " << std::fixed << std::setprecision(2) << stats.cpuShare()
+            << " switches " << stats.voluntarySwitches << "/" << stats.involuntarySwitches
+            << "\n";
+    }
+}
+
+std::string ThreadRegistry::toJson()
+{
+    std::vector<ThreadStats> threads = snapshot();
+    std::ostringstream       out;
+    out << "[";
+    for (size_t i = 0; i < threads.size(); ++i)
+    {
+        out << (i ? "," : "") << "{\"name\":";
+        writeEscaped(out, threads[i].name);
+        out << ",\"tid\":" << threads[i].tid << ",\"cpu_ns\":" << threads[i].cpu.count()
+            << ",\"wall_ns\":" << threads[i].wall.count()
+            << ",\"voluntary_switches\":" << threads[i].voluntarySwitches
+            << ",\"involuntary_switches\":" << threads[i].involuntarySwitches << "}";
+    }
+    out << "]";
+    return out.str();
+}
+
+std::vector<ThreadStats> ThreadRegistry::collect(const void* owner, bool all)
+{
+    // A scope unregisters under the mutex before its thread exits, so every clock held here
+    // belongs to a live thread.
+    std::vector<ThreadStats>    threads;
+    std::lock_guard<std::mutex> lock(_mutex);
+    for (const Scope* scope : _scopes)
+    {
+        if (all || scope->_owner == owner)
+            threads.push_back(sample(*scope));
+    }
+    return threads;
+}
+
+ThreadStats ThreadRegistry::sample(const Scope& scope)
+{
+    if (scope._tid == gettid())
+        return scope.stats();
+
+    ThreadStats stats;
+    stats.name    = scope._name;
+    stats.tid     = scope._tid;
+    stats.cpu     = cpuTime(scope._clock);
+    stats.wall    = std::chrono::steady_clock::now() - scope._start;
+    stats.running = true;
+    readSwitches(scope._tid, stats);
+    return stats;
+}
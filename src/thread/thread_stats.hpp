@@ -0,0 +1,100 @@
+#ifndef _THREAD_STATS_HPP_
+#define _THREAD_STATS_HPP_
+
+#include <sys/types.h>
+#include <time.h>
+
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <vector>
+
+/**
+ * @brief What one thread cost: CPU time, context switches and how long it has existed.
+ *
+ * A thread that burns CPU shows cpu close to wall; one that is starved or keeps blocking shows
+ * the gap, and the switch counters tell which: voluntary switches are waits it asked for,
+ * involuntary ones are the scheduler taking the core away.
+ */
+struct ThreadStats
+{
+    std::string              name;
+    pid_t                    tid = 0;
+    std::chrono::nanoseconds cpu{0};
+    std::chrono::nanoseconds wall{0};
+    uint64_t                 voluntarySwitches   = 0;
+    uint64_t                 involuntarySwitches = 0;
+    bool                     running             = false;
+
+    /** cpu / wall, 0 when no time has passed. */
+    double cpuShare() const;
+
+    /**
+     * @brief Sample the calling thread (CLOCK_THREAD_CPUTIME_ID and getrusage(RUSAGE_THREAD)).
+     * @note wall is left at 0: the thread does not know when it started.
+     */
+    static ThreadStats current();
+};
+
+/**
+ * @brief Process-wide list of the library's live threads, to sample them all at once.
+ *
+ * Thread, WorkerPool and PersistentWorker register their threads for as long as they run;
+ * registering costs a mutex and nothing is measured until someone asks. Other threads are
+ * sampled through their CPU clock and /proc/self/task/<tid>/status.
+ */
+class ThreadRegistry
+{
+public:
+    /**
+     * @brief Registers the calling thread until destroyed. Create it on the thread's own stack.
+     */
+    class Scope
+    {
+    public:
+        /**
+         * @param owner Object the thread works for, to filter snapshot() on; may be null.
+         */
+        Scope(const std::string& name, const void* owner = nullptr);
+        ~Scope();
+
+        Scope(const Scope&)            = delete;
+        Scope& operator=(const Scope&) = delete;
+
+        /** Sample of the calling thread, wall time included. */
+        ThreadStats stats() const;
+
+    private:
+        friend class ThreadRegistry;
+
+        std::string                           _name;
+        const void*                           _owner;
+        pid_t                                 _tid;
+        clockid_t                             _clock;
+        std::chrono::steady_clock::time_point _start;
+    };
+
+    static ThreadRegistry& instance();
+
+    /** Every registered thread, sampled now. */
+    std::vector<ThreadStats> snapshot();
+    /** Only the threads registered with %owner. */
+    std::vector<ThreadStats> snapshot(const void* owner);
+
+    /** One line per thread, for a human. */
+    void        dump(std::ostream& out);
+    std::string toJson();
+
+private:
+    std::mutex          _mutex;
+    std::vector<Scope*> _scopes;
+
+    ThreadRegistry() = default;
+
+    std::vector<ThreadStats> collect(const void* owner, bool all);
+    static ThreadStats       sample(const Scope& scope);
+};
+
+#endif // !_THREAD_STATS_HPP_
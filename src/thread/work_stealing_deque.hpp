@@ -0,0 +1,182 @@
+#ifndef _WORK_STEALING_DEQUE_HPP_
+#define _WORK_STEALING_DEQUE_HPP_
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <type_traits>
+#include <vector>
+
+/**
+ * @brief Chase-Lev work-stealing deque (Le et al., "Correct and Efficient Work-Stealing for
+ * Weak Memory Models").
+ *
+ * The owner thread pushes and pops at the bottom (LIFO), any other thread steals from the top
+ * (FIFO). The ring grows on demand; old rings are kept until destruction because a thief may
+ * still be reading from them.
+ *
+ * Values are stored as relaxed 64-bit words, so that a value wider than a lock-free atomic
+ * needs no lock either. A thief may read a slot the owner is overwriting, but it then loses
+ * the race on _top and drops the torn value.
+ */
+template <typename TType>
+class WorkStealingDeque
+{
+    static_assert(std::is_trivially_copyable<TType>::value,
+                  "WorkStealingDeque only stores trivially copyable values");
+
+private:
+    static constexpr size_t WORDS = (sizeof(TType) + sizeof(uint64_t) - 1) / sizeof(uint64_t);
+
+    class Ring
+    {
+    public:
+        Ring(int64_t capacity)
+            : _capacity(capacity), _mask(capacity - 1),
+              _buffer(std::make_unique<std::atomic<uint64_t>[]>(capacity * WORDS))
+        {
+        }
+
+        int64_t capacity() const
+        {
+            return _capacity;
+        }
+
+        TType get(int64_t index) const
+        {
+            const std::atomic<uint64_t>* slot = &_buffer[(index & _mask) * WORDS];
+            uint64_t                     words[WORDS];
+            for (size_t i = 0; i < WORDS; ++i)
+                words[i] = slot[i].load(std::memory_order_relaxed);
+            TType value;
+            std::memcpy(&value, words, sizeof(TType));
+            return value;
+        }
+
+        void put(int64_t index, TType value)
+        {
+            std::atomic<uint64_t>* slot         = &_buffer[(index & _mask) * WORDS];
+            uint64_t               words[WORDS] = {};
+            std::memcpy(words, &value, sizeof(TType));
+            for (size_t i = 0; i < WORDS; ++i)
+                slot[i].store(words[i], std::memory_order_relaxed);
+        }
+
+        Ring* grow(int64_t bottom, int64_t top) const
+        {
+            Ring* ring = new Ring(_capacity * 2);
+            for (int64_t i = top; i != bottom; ++i)
+                ring->put(i, get(i));
+            return ring;
+        }
+
+    private:
+        int64_t                                  _capacity;
+        int64_t                                  _mask;
+        std::unique_ptr<std::atomic<uint64_t>[]> _buffer;
+    };
+
+    alignas(64) std::atomic<int64_t> _top;
+    alignas(64) std::atomic<int64_t> _bottom;
+    alignas(64) std::atomic<Ring*> _ring;
+    std::vector<std::unique_ptr<Ring>> _rings;
+
+public:
+    /**
+     * @param capacity Initial ring size, rounded up to a power of two.
+     */
+    WorkStealingDeque(size_t capacity = 256) : _top(0), _bottom(0)
+    {
+        int64_t size = 1;
+        while (size < static_cast<int64_t>(capacity))
+            size <<= 1;
+        _rings.emplace_back(std::make_unique<Ring>(size));
+        _ring.store(_rings.back().get(), std::memory_order_relaxed);
+    }
+
+    WorkStealingDeque(const WorkStealingDeque&)            = delete;
+    WorkStealingDeque& operator=(const WorkStealingDeque&) = delete;
+
+    /**
+     * @brief Owner only.
+     */
+    void push(TType value)
+    {
+        int64_t bottom = _bottom.load(std::memory_order_relaxed);
+        int64_t top    = _top.load(std::memory_order_acquire);
+        Ring*   ring   = _ring.load(std::memory_order_relaxed);
+
+        if (bottom - top > ring->capacity() - 1)
+        {
+            _rings.emplace_back(ring->grow(bottom, top));
+            ring = _rings.back().get();
+            _ring.store(ring, std::memory_order_release);
+        }
+        ring->put(bottom, value);
+        std::atomic_thread_fence(std::memory_order_release);
+        _bottom.store(bottom + 1, std::memory_order_relaxed);
+    }
+
+    /**
+     * @brief Owner only: take the most recently pushed value.
+     */
+    bool pop(TType& dest)
+    {
+        int64_t bottom = _bottom.load(std::memory_order_relaxed) - 1;
+        Ring*   ring   = _ring.load(std::memory_order_relaxed);
+        _bottom.store(bottom, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        int64_t top = _top.load(std::memory_order_relaxed);
+
+        if (top > bottom)
+        {
+            _bottom.store(bottom + 1, std::memory_order_relaxed);
+            return false;
+        }
+
+        dest = ring->get(bottom);
+        if (top == bottom)
+        {
+            // Last element: race the thieves for it.
+            bool won = _top.compare_exchange_strong(
+                top, top + 1, std::memory_order_seq_cst, std::memory_order_relaxed);
+            _bottom.store(bottom + 1, std::memory_order_relaxed);
+            return won;
+        }
+        return true;
+    }
+
+    /**
+     * @brief Any thread: take the oldest value.
+     * @return false if the deque was empty or another thread won the race.
+     */
+    bool steal(TType& dest)
+    {
+        int64_t top = _top.load(std::memory_order_acquire);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        int64_t bottom = _bottom.load(std::memory_order_acquire);
+
+        if (top >= bottom)
+            return false;
+
+        Ring* ring  = _ring.load(std::memory_order_acquire);
+        TType value = ring->get(top);
+        if (!_top.compare_exchange_strong(
+                top, top + 1, std::memory_order_seq_cst, std::memory_order_relaxed))
+            return false;
+        dest = value;
+        return true;
+    }
+
+    /**
+     * @note Only a hint when called from a thief.
+     */
+    bool empty() const
+    {
+        return _top.load(std::memory_order_relaxed) >= _bottom.load(std::memory_order_relaxed);
+    }
+};
+
+#endif // !_WORK_STEALING_DEQUE_HPP_
@@ -1,53 +1,637 @@
 #include "worker_pool.hpp"
 
+#include <pthread.h>
+#include <sched.h>
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <bit>
+#include <chrono>
 #include <cstddef>
+#include <cstdint>
 #include <exception>
+#include <functional>
+#include <map>
+#include <memory>
 #include <mutex>
+#include <stdexcept>
+#include <string>
+#include <thread>
 #include <vector>
 
-WorkerPool::WorkerPool(size_t nb_worker) : _stop(false)
+#include "cpu_topology.hpp"
+#include "thread_stats.hpp"
+
+namespace
+{
+#ifdef FTPP_METRICS
+constexpr bool METRICS_COMPILED = true;
+#else
+constexpr bool METRICS_COMPILED = false;
+#endif
+
+struct WorkerContext
+{
+    const WorkerPool* pool  = nullptr;
+    size_t            index = 0;
+};
+
+thread_local WorkerContext currentWorker;
+
+int64_t nowNanoseconds()
+{
+    auto now = std::chrono::steady_clock::now().time_since_epoch();
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(now).count();
+}
+
+uint64_t nextRandom()
+{
+    thread_local uint64_t state = std::hash<std::thread::id>{}(std::this_thread::get_id()) | 1;
+    state ^= state << 13;
+    state ^= state >> 7;
+    state ^= state << 17;
+    return state;
+}
+} // namespace
+
+struct WorkerPool::Metrics
+{
+    // Written by the thread that owns it, except the one shared by non-worker threads.
+    struct Slot
+    {
+        ConcurrentLatencyHistogram queueWait;
+        ConcurrentLatencyHistogram execution;
+        std::atomic<uint64_t>      jobs{0};
+        std::atomic<uint64_t>      failed{0};
+        std::atomic<int64_t>       busy{0};
+        std::atomic<int64_t>       idle{0};
+        // End of the last job (or start of the worker), and whether a job runs now.
+        std::atomic<int64_t> lastEnd{0};
+        std::atomic<bool>    running{false};
+    };
+
+    int64_t                            start = 0;
+    std::vector<std::unique_ptr<Slot>> workers;
+    Slot                               external;
+};
+
+WorkerPool::WorkerPool(size_t nb_worker) : WorkerPool(Options{.workerCount = nb_worker}) {}
+
+WorkerPool::WorkerPool(const Options& options)
+    : _scheduling(options.scheduling), _name(options.name), _wait(options.wait),
+      _jobs(options.aging, options.recordQueueStats), _stop(false), _sleepers(0), _unfinished(0),
+      _elastic(options.maxWorkers > options.workerCount), _minWorkers(options.workerCount),
+      _spawnDepth(options.spawnDepth), _spawnWait(options.spawnWait),
+      _idleTimeout(options.idleTimeout), _activeWorkers(0), _lastProgress(0), _jobCount(0),
+      _queued(0)
+{
+    size_t slots = std::max(options.workerCount, options.maxWorkers);
+    place(options, slots);
+
+    if (METRICS_COMPILED && options.metrics)
+    {
+        _metrics        = std::make_unique<Metrics>();
+        _metrics->start = nowNanoseconds();
+        for (size_t i = 0; i < slots; ++i)
+            _metrics->workers.emplace_back(std::make_unique<Metrics::Slot>());
+    }
+
+    if (_scheduling == Scheduling::WorkStealing)
+    {
+        for (size_t i = 0; i < slots; ++i)
+            _deques.emplace_back(std::make_unique<WorkStealingDeque<Queued>>());
+    }
+
+    progress();
+    _workers.resize(slots);
+    _slotActive.resize(slots, false);
+
+    std::lock_guard<std::mutex> lock(_scaleMtx);
+    for (size_t i = 0; i < slots; ++i)
+    {
+        // Past the minimum, only the first worker of a group that has none yet.
+        if (i < _minWorkers || _groups[_workerGroup[i]]->active == 0)
+            startWorker(i);
+    }
+}
+
+void WorkerPool::place(const Options& options, size_t slots)
+{
+    std::vector<CpuTopology::Cpu> cpus;
+    if (options.placement != Placement::None)
+        cpus = CpuTopology().cpus();
+
+    if (cpus.empty())
+    {
+        // No placement, or the allowed CPUs are unknown: one unpinned group.
+        _groups.emplace_back(std::make_unique<Group>());
+        for (size_t i = 0; i < slots; ++i)
+        {
+            _groups[0]->workers.push_back(i);
+            _workerGroup.push_back(0);
+            _workerCpu.push_back(-1);
+        }
+        return;
+    }
+
+    // Distinct cores first, so that a small pool does not share cores while others idle.
+    cpus = CpuTopology::coresFirst(cpus);
+    std::map<int, size_t> groupOfKey;
+    for (size_t i = 0; i < slots; ++i)
+    {
+        const CpuTopology::Cpu& cpu = cpus[i % cpus.size()];
+        int key = options.placement == Placement::Core ? cpu.core : cpu.cache;
+
+        auto [it, inserted] = groupOfKey.emplace(key, _groups.size());
+        if (inserted)
+            _groups.emplace_back(std::make_unique<Group>());
+        _groups[it->second]->workers.push_back(i);
+        _workerGroup.push_back(it->second);
+        _workerCpu.push_back(cpu.id);
+    }
+}
+
+void WorkerPool::startWorker(size_t index)
+{
+    // A retired worker left this slot free; it is already on its way out.
+    if (_workers[index].joinable())
+        _workers[index].join();
+
+    _slotActive[index] = true;
+    _groups[_workerGroup[index]]->active++;
+    _activeWorkers.fetch_add(1);
+    _workers[index] = std::thread(
+        [this, index]
+        {
+            ThreadRegistry::Scope registration(
+                (_name.empty() ? "worker" : _name) + "-" + std::to_string(index), this);
+            if (_scheduling == Scheduling::WorkStealing)
+                stealingRuntime(index);
+            else
+                runtime(index);
+        });
+}
+
+void WorkerPool::grow(size_t pending, size_t group)
+{
+    // Jobs routed to a group weigh on that group's workers only, and a sleeper of another group
+    // cannot take them.
+    bool   routed = group != NO_GROUP;
+    size_t active = routed ? _groups[group]->active.load() : _activeWorkers.load();
+    if (pending == 0 || _activeWorkers.load() >= _workers.size()
+        || (!routed && _sleepers.load() != 0))
+        return;
+
+    ScalingEvent::Reason reason;
+    if (pending > _spawnDepth * active)
+        reason = ScalingEvent::Reason::QueueDepth;
+    else if (nowNanoseconds() - _lastProgress.load(std::memory_order_relaxed) > _spawnWait.count())
+        reason = ScalingEvent::Reason::QueueWait;
+    else
+        return;
+
+    // Whoever is already spawning a worker covers this call too.
+    std::unique_lock<std::mutex> lock(_scaleMtx, std::try_to_lock);
+    if (!lock.owns_lock() || _stop)
+        return;
+
+    // A worker outside the group would not run its jobs: only its own slots are candidates.
+    const std::vector<size_t>* candidates = routed ? &_groups[group]->workers : nullptr;
+    size_t                     count      = routed ? candidates->size() : _slotActive.size();
+    for (size_t c = 0; c < count; ++c)
+    {
+        size_t i = routed ? (*candidates)[c] : c;
+        if (_slotActive[i])
+            continue;
+        startWorker(i);
+        _scalingEvents.push(
+            {reason, true, i, _activeWorkers.load(), pending, std::chrono::steady_clock::now()});
+        return;
+    }
+}
+
+bool WorkerPool::retire(size_t index)
+{
+    std::lock_guard<std::mutex> lock(_scaleMtx);
+    Group&                      group = *_groups[_workerGroup[index]];
+    if (_stop || _activeWorkers.load() <= _minWorkers || group.active <= 1)
+        return false;
+
+    _slotActive[index] = false;
+    group.active--;
+    _activeWorkers.fetch_sub(1);
+    _scalingEvents.push({ScalingEvent::Reason::IdleTimeout,
+                         false,
+                         index,
+                         _activeWorkers.load(),
+                         0,
+                         std::chrono::steady_clock::now()});
+    return true;
+}
+
+void WorkerPool::progress()
+{
+    if (_elastic)
+    {
+        _lastProgress.store(nowNanoseconds(), std::memory_order_relaxed);
+    }
+}
+
+template <typename TReady>
+bool WorkerPool::park(std::unique_lock<std::mutex>& lock, size_t index, TReady ready)
+{
+    // Announce ourselves before re-checking %ready so addJob cannot miss us.
+    _sleepers.fetch_add(1);
+    bool keep = true;
+    if (!_elastic)
+        _cv.wait(lock, ready);
+    else
+    {
+        while (keep && !_cv.wait_for(lock, _idleTimeout, ready))
+            keep = !retire(index);
+    }
+    _sleepers.fetch_sub(1);
+    return keep;
+}
+
+int64_t WorkerPool::stamp() const
 {
-    for (size_t i = 0; i < nb_worker; ++i)
+    return METRICS_COMPILED && _metrics ? nowNanoseconds() : 0;
+}
+
+void WorkerPool::enterWorker(size_t index)
+{
+    currentWorker = {this, index};
+    if constexpr (METRICS_COMPILED)
     {
-        _workers.emplace_back(&WorkerPool::runtime, this);
+        if (_metrics)
+            _metrics->workers[index]->lastEnd.store(nowNanoseconds(), std::memory_order_relaxed);
+    }
+
+    if (!_name.empty())
+    {
+        std::string name = _name + "-" + std::to_string(index);
+        name.resize(std::min<size_t>(name.size(), 15));
+        pthread_setname_np(pthread_self(), name.c_str());
+    }
+
+    // Best effort: a CPU taken away since construction only costs locality.
+    if (_workerCpu[index] >= 0)
+    {
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        CPU_SET(_workerCpu[index], &set);
+        pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
     }
 }
 
-void WorkerPool::runtime()
+void WorkerPool::runtime(size_t index)
 {
+    enterWorker(index);
+    Group& group = *_groups[_workerGroup[index]];
+
     while (true)
     {
-        IJob* job;
+        Queued queued{nullptr, 0};
+        if (group.queued.load() != 0 && group.jobs.try_pop_front(queued))
+        {
+            group.queued.fetch_sub(1);
+            runJob(queued);
+            continue;
+        }
+
+        // Poll before taking the lock: a job added meanwhile is taken without parking.
+        spinUntil(_wait, [&] { return _jobCount.load() != 0 || group.queued.load() != 0; });
+
         {
             std::unique_lock<std::mutex> lock(_mtx);
-            _cv.wait(lock, [this] { return !_jobs.empty() || _stop; });
+            auto ready = [&] { return !_jobs.empty() || group.queued.load() != 0 || _stop; };
+            if (!ready() && !park(lock, index, ready))
+                return;
 
-            if (_stop && _jobs.empty())
+            if (!_jobs.empty())
+            {
+                queued = _jobs.pop();
+                _jobCount.fetch_sub(1);
+            }
+            else if (_stop && group.queued.load() == 0)
                 return;
+        }
+
+        if (queued.job)
+            runJob(queued);
+    }
+}
+
+void WorkerPool::stealingRuntime(size_t index)
+{
+    enterWorker(index);
+    Group& group = *_groups[_workerGroup[index]];
+
+    while (true)
+    {
+        Queued queued;
+        if (findJob(index, queued))
+        {
+            runJob(queued);
+            continue;
+        }
+        if (spinUntil(_wait, [&] { return _queued.load() != 0 || group.queued.load() != 0; }))
+            continue;
+
+        std::unique_lock<std::mutex> lock(_mtx);
+        auto ready = [&] { return _queued.load() != 0 || group.queued.load() != 0 || _stop; };
+        if (!park(lock, index, ready))
+            return;
+
+        if (_stop && _queued.load() == 0 && group.queued.load() == 0)
+            return;
+    }
+}
 
-            job = _jobs.front();
-            _jobs.pop();
+bool WorkerPool::findJob(size_t index, Queued& queued)
+{
+    Group& group = *_groups[_workerGroup[index]];
+    if (popPrioritized(queued) || _deques[index]->pop(queued))
+    {
+        _queued.fetch_sub(1);
+        return true;
+    }
+    if (group.queued.load() != 0 && group.jobs.try_pop_front(queued))
+    {
+        group.queued.fetch_sub(1);
+        return true;
+    }
+    if (_injected.try_pop_front(queued) || steal(index, queued))
+    {
+        _queued.fetch_sub(1);
+        return true;
+    }
+    return false;
+}
+
+bool WorkerPool::popPrioritized(Queued& queued)
+{
+    if (_jobCount.load() == 0)
+        return false;
+
+    std::lock_guard<std::mutex> lock(_mtx);
+    if (_jobs.empty())
+        return false;
+    queued = _jobs.pop();
+    _jobCount.fetch_sub(1);
+    return true;
+}
+
+bool WorkerPool::steal(size_t index, Queued& queued)
+{
+    // Workers sharing a cache with us first, then anyone.
+    if (index != NO_GROUP && _groups.size() > 1)
+    {
+        const std::vector<size_t>& siblings = _groups[_workerGroup[index]]->workers;
+        size_t                     start    = nextRandom();
+        for (size_t i = 0; i < siblings.size(); ++i)
+        {
+            size_t victim = siblings[(start + i) % siblings.size()];
+            if (victim != index && _deques[victim]->steal(queued))
+                return true;
         }
+    }
+
+    size_t count = _deques.size();
+    for (size_t attempt = 0; attempt < 2 * count; ++attempt)
+    {
+        size_t victim = nextRandom() % count;
+        if (victim != index && _deques[victim]->steal(queued))
+            return true;
+    }
+    return false;
+}
+
+void WorkerPool::runJob(const Queued& queued)
+{
+    IJob* job = queued.job;
+    progress();
+
+    Metrics::Slot* slot  = nullptr;
+    int64_t        start = 0;
+    if constexpr (METRICS_COMPILED)
+    {
+        if (_metrics)
+        {
+            bool worker = currentWorker.pool == this;
+            slot  = worker ? _metrics->workers[currentWorker.index].get() : &_metrics->external;
+            start = nowNanoseconds();
+            slot->queueWait.record(std::max<int64_t>(start - queued.queuedAt, 0));
+            if (worker)
+            {
+                slot->idle.fetch_add(start - slot->lastEnd.load(std::memory_order_relaxed),
+                                     std::memory_order_relaxed);
+                slot->running.store(true, std::memory_order_relaxed);
+            }
+        }
+    }
 
-        try
+    try
+    {
+        job->execute();
+    }
+    catch (...)
+    {
+        if constexpr (METRICS_COMPILED)
         {
-            job->execute();
+            if (slot)
+                slot->failed.fetch_add(1, std::memory_order_relaxed);
         }
-        catch (...)
+        std::lock_guard<std::mutex> lock(_mtxExceptions);
+        _jobsExceptions.push(std::current_exception());
+    }
+
+    if constexpr (METRICS_COMPILED)
+    {
+        if (slot)
         {
-            std::lock_guard<std::mutex> lock(_mtxExceptions);
-            _jobsExceptions.push(std::current_exception());
+            int64_t end = nowNanoseconds();
+            slot->execution.record(end - start);
+            slot->jobs.fetch_add(1, std::memory_order_relaxed);
+            if (slot != &_metrics->external)
+            {
+                slot->busy.fetch_add(end - start, std::memory_order_relaxed);
+                slot->lastEnd.store(end, std::memory_order_relaxed);
+                slot->running.store(false, std::memory_order_relaxed);
+            }
         }
     }
+
+    if (_unfinished.fetch_sub(1, std::memory_order_acq_rel) == 1)
+        _unfinished.notify_all();
 }
 
 void WorkerPool::addJob(IJob* job)
 {
+    _unfinished.fetch_add(1, std::memory_order_relaxed);
+    int64_t queuedAt = stamp();
+    if (_scheduling == Scheduling::WorkStealing)
+    {
+        // Counted before it becomes visible, so a worker never parks while it is pending.
+        _queued.fetch_add(1);
+        if (currentWorker.pool == this)
+            _deques[currentWorker.index]->push({job, queuedAt});
+        else
+            _injected.push_back({job, queuedAt});
+
+        if (_sleepers.load() != 0)
+        {
+            std::lock_guard<std::mutex> lock(_mtx);
+            _cv.notify_one();
+        }
+        if (_elastic)
+            grow(_queued.load());
+        return;
+    }
+
+    size_t pending;
+    bool   wake;
+    {
+        std::lock_guard<std::mutex> lock(_mtx);
+        _jobs.push(job, JobOptions(), queuedAt);
+        _jobCount.fetch_add(1);
+        pending = _jobs.size();
+        // Sleepers only change under the lock, so a busy pool skips the futex call.
+        wake = _sleepers.load() != 0;
+    }
+    if (wake)
+        _cv.notify_one();
+    if (_elastic)
+        grow(pending);
+}
+
+void WorkerPool::addJob(IJob* job, const JobOptions& options)
+{
+    _unfinished.fetch_add(1, std::memory_order_relaxed);
+    int64_t queuedAt = stamp();
+    size_t  pending;
+    if (_scheduling == Scheduling::WorkStealing)
+    {
+        // Counted before it becomes visible, as in addJob(IJob*).
+        pending = _queued.fetch_add(1) + 1;
+        std::lock_guard<std::mutex> lock(_mtx);
+        _jobs.push(job, options, queuedAt);
+        _jobCount.fetch_add(1);
+        if (_sleepers.load() != 0)
+            _cv.notify_one();
+    }
+    else
+    {
+        bool wake;
+        {
+            std::lock_guard<std::mutex> lock(_mtx);
+            _jobs.push(job, options, queuedAt);
+            _jobCount.fetch_add(1);
+            pending = _jobs.size();
+            wake    = _sleepers.load() != 0;
+        }
+        if (wake)
+            _cv.notify_one();
+    }
+    if (_elastic)
+        grow(pending);
+}
+
+void WorkerPool::addJob(IJob* job, size_t group)
+{
+    if (group >= _groups.size())
+        throw std::out_of_range("WorkerPool: unknown group");
+
+    _unfinished.fetch_add(1, std::memory_order_relaxed);
+    int64_t queuedAt = stamp();
+    Group&  target   = *_groups[group];
+    size_t  pending  = target.queued.fetch_add(1) + 1;
+    target.jobs.push_back({job, queuedAt});
+
+    // Only some workers may take it, so wake them all.
+    if (_sleepers.load() != 0)
+    {
+        std::lock_guard<std::mutex> lock(_mtx);
+        _cv.notify_all();
+    }
+    if (_elastic)
+        grow(pending, group);
+}
+
+bool WorkerPool::runPendingJob()
+{
+    Queued queued;
+    if (_scheduling == Scheduling::WorkStealing)
+    {
+        if (currentWorker.pool == this)
+        {
+            if (!findJob(currentWorker.index, queued))
+                return false;
+        }
+        else
+        {
+            if (!popPrioritized(queued) && !_injected.try_pop_front(queued)
+                && !steal(NO_GROUP, queued))
+                return false;
+            _queued.fetch_sub(1);
+        }
+    }
+    else
     {
         std::lock_guard<std::mutex> lock(_mtx);
-        _jobs.push(job);
+        if (_jobs.empty())
+            return false;
+        queued = _jobs.pop();
+        _jobCount.fetch_sub(1);
+    }
+
+    runJob(queued);
+    return true;
+}
+
+WorkerPool::ScheduleAwaiter WorkerPool::schedule()
+{
+    return ScheduleAwaiter(*this);
+}
+
+size_t WorkerPool::workerCount() const
+{
+    return _activeWorkers.load();
+}
+
+size_t WorkerPool::groupCount() const
+{
+    return _groups.size();
+}
+
+size_t WorkerPool::workerGroup(size_t worker) const
+{
+    return _workerGroup.at(worker);
+}
+
+int WorkerPool::workerCpu(size_t worker) const
+{
+    return _workerCpu.at(worker);
+}
+
+size_t WorkerPool::currentGroup() const
+{
+    return currentWorker.pool == this ? _workerGroup[currentWorker.index] : NO_GROUP;
+}
+
+void WorkerPool::waitIdle()
+{
+    if (currentWorker.pool == this)
+        throw std::logic_error("WorkerPool::waitIdle called from a worker");
+
+    size_t unfinished;
+    while ((unfinished = _unfinished.load(std::memory_order_acquire)) != 0)
+    {
+        if (!runPendingJob())
+            _unfinished.wait(unfinished, std::memory_order_acquire);
     }
-    _cv.notify_one();
 }
 
 std::vector<std::exception_ptr> WorkerPool::getExceptions()
@@ -62,10 +646,89 @@ std::vector<std::exception_ptr> WorkerPool::getExceptions()
     return result;
 }
 
+WorkerPool::QueueStats WorkerPool::queueStats(Priority priority)
+{
+    std::lock_guard<std::mutex> lock(_mtx);
+    return _jobs.stats(priority);
+}
+
+void WorkerPool::resetQueueStats()
+{
+    std::lock_guard<std::mutex> lock(_mtx);
+    for (size_t i = 0; i < PRIORITY_COUNT; ++i)
+        _jobs.stats(static_cast<Priority>(i)) = QueueStats();
+}
+
+bool WorkerPool::metricsCompiled()
+{
+    return METRICS_COMPILED;
+}
+
+PoolMetricsSnapshot WorkerPool::metricsSnapshot()
+{
+    PoolMetricsSnapshot snapshot;
+    if (!_metrics)
+        return snapshot;
+
+    int64_t now            = nowNanoseconds();
+    snapshot.enabled       = true;
+    snapshot.elapsed       = std::chrono::nanoseconds(now - _metrics->start);
+    snapshot.jobsPending   = _unfinished.load(std::memory_order_relaxed);
+    snapshot.jobsCompleted = _metrics->external.jobs.load(std::memory_order_relaxed);
+    snapshot.jobsFailed    = _metrics->external.failed.load(std::memory_order_relaxed);
+    snapshot.queueWait     = _metrics->external.queueWait.snapshot();
+    snapshot.execution     = _metrics->external.execution.snapshot();
+
+    std::vector<bool> active;
+    {
+        std::lock_guard<std::mutex> lock(_scaleMtx);
+        active = _slotActive;
+    }
+    for (size_t i = 0; i < _metrics->workers.size(); ++i)
+    {
+        const Metrics::Slot&        slot = *_metrics->workers[i];
+        PoolMetricsSnapshot::Worker worker;
+        worker.jobs = slot.jobs.load(std::memory_order_relaxed);
+        worker.busy = std::chrono::nanoseconds(slot.busy.load(std::memory_order_relaxed));
+        worker.idle = std::chrono::nanoseconds(slot.idle.load(std::memory_order_relaxed));
+
+        // Count the idle stretch in progress too.
+        int64_t lastEnd = slot.lastEnd.load(std::memory_order_relaxed);
+        if (active[i] && lastEnd != 0 && !slot.running.load(std::memory_order_relaxed))
+            worker.idle += std::chrono::nanoseconds(std::max<int64_t>(now - lastEnd, 0));
+
+        snapshot.workers.push_back(worker);
+        snapshot.jobsCompleted += worker.jobs;
+        snapshot.jobsFailed += slot.failed.load(std::memory_order_relaxed);
+        snapshot.queueWait.merge(slot.queueWait.snapshot());
+        snapshot.execution.merge(slot.execution.snapshot());
+    }
+    return snapshot;
+}
+
+std::vector<ThreadStats> WorkerPool::threadStats() const
+{
+    return ThreadRegistry::instance().snapshot(this);
+}
+
+std::vector<WorkerPool::ScalingEvent> WorkerPool::getScalingEvents()
+{
+    std::lock_guard<std::mutex> lock(_scaleMtx);
+    std::vector<ScalingEvent>   result;
+    while (!_scalingEvents.empty())
+    {
+        result.push_back(_scalingEvents.front());
+        _scalingEvents.pop();
+    }
+    return result;
+}
+
 WorkerPool::~WorkerPool()
 {
     {
+        // Both locks: retire() and grow() read _stop under _scaleMtx.
         std::lock_guard<std::mutex> lock(_mtx);
+        std::lock_guard<std::mutex> scale(_scaleMtx);
         _stop = true;
     }
     _cv.notify_all();
@@ -80,3 +743,120 @@ WorkerPool::~WorkerPool()
 }
 
 WorkerPool::IJob::~IJob() {};
+
+WorkerPool::JobQueue::JobQueue(
+    const std::array<std::chrono::microseconds, PRIORITY_COUNT>& aging, bool recordStats)
+    : _size(0), _recordStats(recordStats), _timed(false), _timedSince(0)
+{
+    for (size_t i = 0; i < PRIORITY_COUNT; ++i)
+        _aging[i] = std::chrono::duration_cast<std::chrono::nanoseconds>(aging[i]).count();
+}
+
+bool WorkerPool::JobQueue::empty() const
+{
+    return _size == 0;
+}
+
+size_t WorkerPool::JobQueue::size() const
+{
+    return _size;
+}
+
+void WorkerPool::JobQueue::push(IJob* job, const JobOptions& options, int64_t queuedAt)
+{
+    // While every job is plain, the queue is a FIFO and needs no clock.
+    bool    ordered = options.priority != Priority::Normal
+                      || options.deadline != std::chrono::steady_clock::time_point();
+    int64_t now     = queuedAt;
+    if (now == 0 && (_recordStats || _timed || ordered))
+        now = nowNanoseconds();
+    if (ordered && !_timed)
+    {
+        _timed      = true;
+        _timedSince = now;
+    }
+
+    Entry entry{job, now, 0, options.priority};
+    if (options.deadline == std::chrono::steady_clock::time_point())
+        _classes[static_cast<size_t>(options.priority)].push(entry);
+    else
+    {
+        entry.deadline = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                             options.deadline.time_since_epoch())
+                             .count();
+        _deadlines.push_back(entry);
+        std::push_heap(_deadlines.begin(),
+                       _deadlines.end(),
+                       [](const Entry& a, const Entry& b) { return a.deadline > b.deadline; });
+    }
+    _size++;
+}
+
+WorkerPool::Queued WorkerPool::JobQueue::pop()
+{
+    // Earliest effective deadline among the heap top and the head of every class.
+    const Entry*       best      = _deadlines.empty() ? nullptr : &_deadlines.front();
+    int64_t            due       = best ? best->deadline : INT64_MAX;
+    RingBuffer<Entry>* fromClass = nullptr;
+    for (size_t i = 0; i < PRIORITY_COUNT; ++i)
+    {
+        if (_classes[i].empty())
+            continue;
+        const Entry& head     = _classes[i].front();
+        int64_t      enqueued = head.enqueued ? head.enqueued : _timedSince;
+        if (enqueued + _aging[i] < due)
+        {
+            due       = enqueued + _aging[i];
+            best      = &head;
+            fromClass = &_classes[i];
+        }
+    }
+
+    Entry entry = *best;
+    if (fromClass)
+        fromClass->pop();
+    else
+    {
+        std::pop_heap(_deadlines.begin(),
+                      _deadlines.end(),
+                      [](const Entry& a, const Entry& b) { return a.deadline > b.deadline; });
+        _deadlines.pop_back();
+    }
+    _size--;
+    if (!_recordStats)
+        return {entry.job, entry.enqueued};
+
+    int64_t     now   = nowNanoseconds();
+    int64_t     wait  = std::max<int64_t>(now - entry.enqueued, 0);
+    QueueStats& stats = _stats[static_cast<size_t>(entry.priority)];
+    stats.count++;
+    stats.total += std::chrono::nanoseconds(wait);
+    stats.max = std::max(stats.max, std::chrono::nanoseconds(wait));
+    stats.histogram[wait == 0 ? 0 : std::bit_width(static_cast<uint64_t>(wait)) - 1]++;
+    if (entry.deadline != 0 && now > entry.deadline)
+        stats.missedDeadlines++;
+    return {entry.job, entry.enqueued};
+}
+
+WorkerPool::QueueStats& WorkerPool::JobQueue::stats(Priority priority)
+{
+    return _stats[static_cast<size_t>(priority)];
+}
+
+std::chrono::nanoseconds WorkerPool::QueueStats::mean() const
+{
+    return count == 0 ? std::chrono::nanoseconds(0) : total / static_cast<int64_t>(count);
+}
+
+std::chrono::nanoseconds WorkerPool::QueueStats::percentile(double quantile) const
+{
+    uint64_t target = static_cast<uint64_t>(quantile * static_cast<double>(count));
+    uint64_t seen   = 0;
+    for (size_t i = 0; i < histogram.size(); ++i)
+    {
+        seen += histogram[i];
+        if (i < 62 && (seen > target || (seen == count && histogram[i] != 0)))
+            return std::min(max, std::chrono::nanoseconds((int64_t(2) << i) - 1));
+    }
+    return max;
+}
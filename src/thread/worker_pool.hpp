@@ -1,14 +1,31 @@
 #ifndef _WORKER_POOL_HPP_
 #define _WORKER_POOL_HPP_
 
+#include <array>
+#include <atomic>
+#include <chrono>
 #include <condition_variable>
+#include <coroutine>
 #include <cstddef>
+#include <cstdint>
 #include <exception>
+#include <memory>
 #include <mutex>
 #include <queue>
+#include <string>
 #include <thread>
+#include <type_traits>
 #include <vector>
 
+#include "future.hpp"
+#include "inline_function.hpp"
+#include "lock_free_queue.hpp"
+#include "pool_metrics.hpp"
+#include "ring_buffer.hpp"
+#include "spin_wait.hpp"
+#include "thread_stats.hpp"
+#include "work_stealing_deque.hpp"
+
 class WorkerPool
 {
 public:
@@ -19,22 +36,410 @@ public:
         virtual ~IJob();
     };
 
+    enum class Scheduling
+    {
+        /** One FIFO queue shared by every worker. */
+        Shared,
+        /**
+         * One Chase-Lev deque per worker. Jobs added from inside a job go to the local deque
+         * and are popped LIFO; idle workers steal from random victims. Jobs added from outside
+         * the pool go through a lock-free injection queue.
+         */
+        WorkStealing,
+    };
+
+    enum class Placement
+    {
+        /** Workers are not pinned and form a single group. */
+        None,
+        /**
+         * Each worker is pinned to one allowed CPU. Workers take a CPU on every physical core,
+         * cache domain by cache domain, before any goes to an SMT sibling, and wrap around when
+         * there are more workers than CPUs. Workers on SMT siblings of a core form a group.
+         */
+        Core,
+        /** Pinned as with Core; workers sharing a last-level cache form a group. */
+        Cache,
+    };
+
+    enum class Priority
+    {
+        Urgent,
+        High,
+        Normal,
+        Low,
+    };
+
+    static constexpr size_t PRIORITY_COUNT = 4;
+
+    struct Options
+    {
+        size_t     workerCount = std::thread::hardware_concurrency();
+        Scheduling scheduling  = Scheduling::Shared;
+        Placement  placement   = Placement::None;
+        /** Workers are named "<name>-<index>", cut to the 15 characters Linux keeps. */
+        std::string name = "worker";
+        /** How long an idle worker polls for new jobs before parking on the condition. */
+        WaitPolicy wait = WaitPolicy();
+        /**
+         * Record metricsSnapshot() data. Only honoured when the library is built with
+         * FTPP_METRICS (make METRICS=1); otherwise the recording code is not even compiled.
+         */
+        bool metrics = false;
+
+        /**
+         * Above workerCount, the pool is elastic: workerCount becomes the minimum and extra
+         * workers are spawned, up to maxWorkers, when addJob() finds the queue too deep or
+         * stalled. They retire after idleTimeout without work. A placed pool never shrinks
+         * below one worker per group.
+         */
+        size_t maxWorkers = 0;
+        /** Spawn when more than spawnDepth jobs per running worker are queued. */
+        size_t spawnDepth = 8;
+        /** Spawn when jobs are queued and no worker took one for that long. */
+        std::chrono::microseconds spawnWait   = std::chrono::milliseconds(1);
+        std::chrono::milliseconds idleTimeout = std::chrono::seconds(5);
+
+        /**
+         * Queued jobs are served earliest effective deadline first, where a job without an
+         * explicit deadline is due at its enqueue time plus the aging of its priority. A job
+         * therefore waits at most the aging difference longer than a more urgent one queued at
+         * the same time, and no class starves.
+         */
+        std::array<std::chrono::microseconds, PRIORITY_COUNT> aging = {
+            std::chrono::microseconds(0),
+            std::chrono::milliseconds(1),
+            std::chrono::milliseconds(10),
+            std::chrono::milliseconds(100),
+        };
+        /**
+         * Record queueStats(). Costs two clock reads per job, which plain jobs otherwise skip
+         * until the pool sees a priority other than Normal or a deadline.
+         */
+        bool recordQueueStats = false;
+    };
+
+    struct JobOptions
+    {
+        Priority priority = Priority::Normal;
+        /** Optional; replaces the aging of the priority when set. */
+        std::chrono::steady_clock::time_point deadline{};
+    };
+
+    /**
+     * @brief Time spent in the queue by the jobs of one priority.
+     */
+    struct QueueStats
+    {
+        uint64_t                 count = 0;
+        /** Jobs taken after their explicit deadline. */
+        uint64_t                 missedDeadlines = 0;
+        std::chrono::nanoseconds total{0};
+        std::chrono::nanoseconds max{0};
+        /** histogram[i] counts waits in [2^i, 2^(i+1)) nanoseconds. */
+        std::array<uint64_t, 64> histogram{};
+
+        std::chrono::nanoseconds mean() const;
+
+        /**
+         * @brief Upper bound of the wait of the %quantile (0 to 1) job, within a factor of 2.
+         */
+        std::chrono::nanoseconds percentile(double quantile) const;
+    };
+
+    struct ScalingEvent
+    {
+        enum class Reason
+        {
+            QueueDepth,
+            QueueWait,
+            IdleTimeout,
+        };
+
+        Reason                                reason;
+        bool                                  spawned;
+        size_t                                worker;
+        /** Running workers after the event. */
+        size_t                                workerCount;
+        size_t                                pending;
+        std::chrono::steady_clock::time_point time;
+    };
+
+    static constexpr size_t NO_GROUP = static_cast<size_t>(-1);
+
     WorkerPool(size_t nb_worker);
+    WorkerPool(const Options& options);
     ~WorkerPool();
 
-    void                            addJob(IJob* job);
+    void addJob(IJob* job);
+
+    /**
+     * @brief Queue %job with a priority and an optional deadline.
+     *
+     * In work-stealing mode these jobs bypass the per-worker deques and go through the same
+     * ordered queue as the shared mode, which workers check before their own deque.
+     */
+    void addJob(IJob* job, const JobOptions& options);
+
+    /**
+     * @brief Queue %job for the workers of %group only.
+     *
+     * In work-stealing mode those workers also steal from each other before looking at the
+     * rest of the pool, so related jobs keep hitting the same cache.
+     * @throw std::out_of_range on an unknown group.
+     */
+    void addJob(IJob* job, size_t group);
+
     std::vector<std::exception_ptr> getExceptions();
 
+    /**
+     * @brief Return once every job added so far, and any job they add, has finished.
+     *
+     * The calling thread runs queued jobs while it waits. Unlike destroying the pool, this keeps
+     * the workers alive for the next batch.
+     * @throw std::logic_error if called from one of the pool's workers, which would wait for
+     * itself.
+     */
+    void waitIdle();
+
+    /**
+     * @brief Whether this build of the library can record metrics at all.
+     */
+    static bool metricsCompiled();
+
+    /**
+     * @brief Per-worker busy and idle time, queue wait and execution histograms, job counters.
+     * @note Recording is per worker and lock-free; the snapshot merges the workers.
+     */
+    PoolMetricsSnapshot metricsSnapshot();
+
+    /**
+     * @brief CPU time and context switches of each live worker thread, sampled now.
+     */
+    std::vector<ThreadStats> threadStats() const;
+
+    /**
+     * @brief Spawns and retirements of an elastic pool since the last call.
+     */
+    std::vector<ScalingEvent> getScalingEvents();
+
+    /**
+     * @brief Queue latency of the jobs of %priority that went through the ordered queue.
+     * @note Empty unless Options::recordQueueStats is set.
+     */
+    QueueStats queueStats(Priority priority);
+    void       resetQueueStats();
+
+    /**
+     * @brief Workers currently running; varies over time in an elastic pool.
+     */
+    size_t workerCount() const;
+
+    size_t groupCount() const;
+    size_t workerGroup(size_t worker) const;
+
+    /**
+     * @brief CPU %worker is pinned to, or -1 without placement.
+     */
+    int workerCpu(size_t worker) const;
+
+    /**
+     * @brief Group of the calling worker, or NO_GROUP outside this pool.
+     */
+    size_t currentGroup() const;
+
+    /**
+     * @brief Run one queued job on the calling thread, if any.
+     * @return false if no job could be taken.
+     * @note Lets a thread that waits on pool work help instead of blocking.
+     */
+    bool runPendingJob();
+
+    /**
+     * @brief Run %func(%args...) on the pool and get its result back through a Future.
+     *
+     * The callable and its arguments are stored inline in a recycled job node, so steady-state
+     * submission does not allocate as long as they fit the small buffer. An exception thrown by
+     * the task is delivered by Future::get() instead of getExceptions().
+     */
+    template <typename TFunc, typename... TArgs>
+    auto submit(TFunc&& func, TArgs&&... args)
+        -> Future<std::invoke_result_t<std::decay_t<TFunc>, std::decay_t<TArgs>...>>;
+
+    template <typename TFunc, typename... TArgs>
+    auto submit(const JobOptions& options, TFunc&& func, TArgs&&... args)
+        -> Future<std::invoke_result_t<std::decay_t<TFunc>, std::decay_t<TArgs>...>>;
+
+    /**
+     * @brief Like submit(), but only the workers of %group run the task.
+     */
+    template <typename TFunc, typename... TArgs>
+    auto submitTo(size_t group, TFunc&& func, TArgs&&... args)
+        -> Future<std::invoke_result_t<std::decay_t<TFunc>, std::decay_t<TArgs>...>>;
+
+    /**
+     * @brief Awaitable that moves the awaiting coroutine onto a pool worker.
+     *
+     * The awaiter is itself the job, stored in the coroutine frame, so scheduling does not
+     * allocate.
+     */
+    class ScheduleAwaiter : public IJob
+    {
+    public:
+        explicit ScheduleAwaiter(WorkerPool& pool) : _pool(pool) {}
+
+        bool await_ready() const noexcept
+        {
+            return false;
+        }
+
+        void await_suspend(std::coroutine_handle<> handle)
+        {
+            _handle = handle;
+            _pool.addJob(this);
+        }
+
+        void await_resume() const noexcept {}
+
+        void execute() override
+        {
+            _handle.resume();
+        }
+
+    private:
+        WorkerPool&             _pool;
+        std::coroutine_handle<> _handle;
+    };
+
+    /**
+     * @brief `co_await pool.schedule();` continues the coroutine on one of the workers.
+     */
+    ScheduleAwaiter schedule();
+
 private:
-    std::queue<IJob*>              _jobs;
+    template <typename TResult>
+    class PackagedJob;
+
+    template <typename TFunc, typename... TArgs>
+    static auto package(TFunc&& func, TArgs&&... args);
+
+    // A queued job and its enqueue time in ns, 0 unless something needed the clock. Kept beside
+    // the pointer so that the layout of IJob does not depend on the build.
+    struct Queued
+    {
+        IJob*   job;
+        int64_t queuedAt;
+    };
+
+    // Shared queue ordered by effective deadline; always used under _mtx.
+    class JobQueue
+    {
+    public:
+        JobQueue(const std::array<std::chrono::microseconds, PRIORITY_COUNT>& aging,
+                 bool recordStats);
+
+        bool   empty() const;
+        size_t size() const;
+        // %queuedAt is the enqueue time if the caller read the clock already, 0 otherwise.
+        void   push(IJob* job, const JobOptions& options, int64_t queuedAt);
+        Queued pop();
+
+        QueueStats& stats(Priority priority);
+
+    private:
+        struct Entry
+        {
+            IJob*    job;
+            int64_t  enqueued;
+            int64_t  deadline;
+            Priority priority;
+        };
+
+        // FIFO per priority for implicit deadlines, min-heap for explicit ones.
+        std::array<RingBuffer<Entry>, PRIORITY_COUNT> _classes;
+        std::vector<Entry>                            _deadlines;
+        std::array<int64_t, PRIORITY_COUNT>           _aging;
+        std::array<QueueStats, PRIORITY_COUNT>        _stats;
+        size_t                                        _size;
+        bool                                          _recordStats;
+        // Set by the first job that needs ordering by time; plain jobs queued before it were
+        // not timestamped and count as enqueued at _timedSince.
+        bool                                          _timed;
+        int64_t                                       _timedSince;
+    };
+
+    struct Metrics;
+
+    // Workers placed together and the jobs routed to them.
+    struct Group
+    {
+        std::vector<size_t>   workers;
+        LockFreeQueue<Queued> jobs;
+        std::atomic<size_t>   queued{0};
+        // Running workers, changed under _scaleMtx.
+        std::atomic<size_t> active{0};
+    };
+
+    Scheduling                     _scheduling;
+    std::string                    _name;
+    WaitPolicy                     _wait;
+    JobQueue                       _jobs;
     std::queue<std::exception_ptr> _jobsExceptions;
     std::vector<std::thread>       _workers;
     bool                           _stop;
     std::mutex                     _mtx;
     std::mutex                     _mtxExceptions;
     std::condition_variable        _cv;
+    // Workers parked on _cv.
+    std::atomic<size_t> _sleepers;
+    // Jobs added and not finished yet, for waitIdle().
+    std::atomic<size_t> _unfinished;
+
+    std::vector<std::unique_ptr<Group>> _groups;
+    std::vector<size_t>                 _workerGroup;
+    std::vector<int>                    _workerCpu;
+
+    // Elastic mode: _workers holds one slot per possible worker, started on demand.
+    bool                      _elastic;
+    size_t                    _minWorkers;
+    size_t                    _spawnDepth;
+    std::chrono::nanoseconds  _spawnWait;
+    std::chrono::milliseconds _idleTimeout;
+    std::atomic<size_t>       _activeWorkers;
+    std::atomic<int64_t>      _lastProgress;
+    std::vector<bool>         _slotActive;
+    std::queue<ScalingEvent>  _scalingEvents;
+    std::mutex                _scaleMtx;
 
-    void runtime();
+    // Jobs waiting in _jobs, readable without the lock.
+    std::atomic<size_t> _jobCount;
+
+    // Null unless metrics are compiled in and enabled.
+    std::unique_ptr<Metrics> _metrics;
+
+    // Work-stealing mode only.
+    std::vector<std::unique_ptr<WorkStealingDeque<Queued>>> _deques;
+    LockFreeQueue<Queued>                                   _injected;
+    std::atomic<size_t>                                     _queued;
+
+    void    place(const Options& options, size_t slots);
+    void    startWorker(size_t index);
+    void    grow(size_t pending, size_t group = NO_GROUP);
+    bool    retire(size_t index);
+    void    progress();
+    int64_t stamp() const;
+    void    enterWorker(size_t index);
+    void    runtime(size_t index);
+    void    stealingRuntime(size_t index);
+    bool    findJob(size_t index, Queued& queued);
+    bool    steal(size_t index, Queued& queued);
+    bool    popPrioritized(Queued& queued);
+    void    runJob(const Queued& queued);
+
+    template <typename TReady>
+    bool park(std::unique_lock<std::mutex>& lock, size_t index, TReady ready);
 };
 
+#include "worker_pool.tpp"
+
 #endif // !_WORKER_POOL_HPP_
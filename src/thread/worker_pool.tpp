@@ -0,0 +1,226 @@
+#ifndef _WORKER_POOL_TPP_
+#define _WORKER_POOL_TPP_
+
+#include <atomic>
+#include <cstddef>
+#include <exception>
+#include <functional>
+#include <stdexcept>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "worker_pool.hpp"
+
+/**
+ * @brief Job node that is also the shared state of the Future handed to the caller.
+ *
+ * Nodes are kept in a cache of the thread that allocated them once both the job and the Future
+ * have released them. A node released on another thread, a worker dropping a fire-and-forget
+ * job for instance, is pushed back to its home thread, which picks it up on its next submit:
+ * a thread that only submits keeps reusing its own nodes instead of allocating every time.
+ */
+template <typename TResult>
+class WorkerPool::PackagedJob : public WorkerPool::IJob, public FutureState<TResult>
+{
+private:
+    static constexpr size_t CACHE_SIZE = 256;
+
+    // Outlives its thread for as long as some of its nodes are still out.
+    struct Home
+    {
+        std::atomic<PackagedJob*> returned{nullptr};
+        std::atomic<size_t>       refs{1};
+
+        void unref()
+        {
+            if (refs.fetch_sub(1, std::memory_order_acq_rel) == 1)
+                delete this;
+        }
+    };
+
+    struct Cache
+    {
+        std::vector<PackagedJob*> nodes;
+        Home*                     home = new Home();
+
+        ~Cache()
+        {
+            for (auto node : nodes)
+                node->destroy();
+            // Nodes returned from now on are deleted by whoever releases them.
+            destroyList(home->returned.exchange(closed(), std::memory_order_acquire));
+            home->unref();
+        }
+
+        void reclaim()
+        {
+            if (home->returned.load(std::memory_order_relaxed) == nullptr)
+                return;
+            PackagedJob* node = home->returned.exchange(nullptr, std::memory_order_acquire);
+            while (node && nodes.size() < CACHE_SIZE)
+            {
+                nodes.push_back(node);
+                node = node->_next;
+            }
+            destroyList(node);
+        }
+    };
+
+    static Cache& cache()
+    {
+        thread_local Cache local;
+        return local;
+    }
+
+    static PackagedJob* closed()
+    {
+        static char marker;
+        return reinterpret_cast<PackagedJob*>(&marker);
+    }
+
+    static void destroyList(PackagedJob* node)
+    {
+        while (node)
+        {
+            PackagedJob* next = node->_next;
+            node->destroy();
+            node = next;
+        }
+    }
+
+    InlineFunction<TResult()> _func;
+    Home*                     _home;
+    PackagedJob*              _next;
+
+    explicit PackagedJob(Home* home) : FutureState<TResult>(2), _home(home), _next(nullptr)
+    {
+        _home->refs.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    void destroy()
+    {
+        Home* home = _home;
+        delete this;
+        home->unref();
+    }
+
+protected:
+    void recycle() override
+    {
+        Cache& local = cache();
+        if (_home == local.home)
+        {
+            if (local.nodes.size() < CACHE_SIZE)
+                local.nodes.push_back(this);
+            else
+                destroy();
+            return;
+        }
+
+        PackagedJob* head = _home->returned.load(std::memory_order_relaxed);
+        do
+        {
+            if (head == closed())
+            {
+                destroy();
+                return;
+            }
+            _next = head;
+        } while (!_home->returned.compare_exchange_weak(head, this, std::memory_order_release,
+                                                        std::memory_order_relaxed));
+    }
+
+public:
+    /**
+     * @brief Get a node owned twice: once by the job, once by the Future.
+     */
+    static PackagedJob* acquire(InlineFunction<TResult()>&& func)
+    {
+        Cache& local = cache();
+        if (local.nodes.empty())
+            local.reclaim();
+
+        PackagedJob* job;
+        if (local.nodes.empty())
+        {
+            job = new PackagedJob(local.home);
+        }
+        else
+        {
+            job = local.nodes.back();
+            local.nodes.pop_back();
+            job->rearm(2);
+        }
+        job->_func = std::move(func);
+        return job;
+    }
+
+    void execute() override
+    {
+        try
+        {
+            if constexpr (std::is_void_v<TResult>)
+            {
+                _func();
+                this->setValue();
+            }
+            else
+            {
+                this->setValue(_func());
+            }
+        }
+        catch (...)
+        {
+            this->setException(std::current_exception());
+        }
+        _func = nullptr;
+        this->release();
+    }
+};
+
+template <typename TFunc, typename... TArgs>
+auto WorkerPool::package(TFunc&& func, TArgs&&... args)
+{
+    using TResult = std::invoke_result_t<std::decay_t<TFunc>, std::decay_t<TArgs>...>;
+
+    return PackagedJob<TResult>::acquire(
+        [func = std::forward<TFunc>(func), ... args = std::forward<TArgs>(args)]() mutable
+        { return std::invoke(std::move(func), std::move(args)...); });
+}
+
+template <typename TFunc, typename... TArgs>
+auto WorkerPool::submit(TFunc&& func, TArgs&&... args)
+    -> Future<std::invoke_result_t<std::decay_t<TFunc>, std::decay_t<TArgs>...>>
+{
+    auto* job = package(std::forward<TFunc>(func), std::forward<TArgs>(args)...);
+    Future<std::invoke_result_t<std::decay_t<TFunc>, std::decay_t<TArgs>...>> future(job);
+    addJob(job);
+    return future;
+}
+
+template <typename TFunc, typename... TArgs>
+auto WorkerPool::submit(const JobOptions& options, TFunc&& func, TArgs&&... args)
+    -> Future<std::invoke_result_t<std::decay_t<TFunc>, std::decay_t<TArgs>...>>
+{
+    auto* job = package(std::forward<TFunc>(func), std::forward<TArgs>(args)...);
+    Future<std::invoke_result_t<std::decay_t<TFunc>, std::decay_t<TArgs>...>> future(job);
+    addJob(job, options);
+    return future;
+}
+
+template <typename TFunc, typename... TArgs>
+auto WorkerPool::submitTo(size_t group, TFunc&& func, TArgs&&... args)
+    -> Future<std::invoke_result_t<std::decay_t<TFunc>, std::decay_t<TArgs>...>>
+{
+    // Checked first so a bad group does not leak a packaged job.
+    if (group >= _groups.size())
+        throw std::out_of_range("WorkerPool: unknown group");
+    auto* job = package(std::forward<TFunc>(func), std::forward<TArgs>(args)...);
+    Future<std::invoke_result_t<std::decay_t<TFunc>, std::decay_t<TArgs>...>> future(job);
+    addJob(job, group);
+    return future;
+}
+
+#endif // !_WORKER_POOL_TPP_
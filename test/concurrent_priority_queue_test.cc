@@ -0,0 +1,99 @@
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "concurrent_priority_queue.hpp"
+
+TEST(ConcurrentPriorityQueueTest, SingleShardIsStrict)
+{
+    ConcurrentPriorityQueue<std::string> queue(1);
+
+    queue.push("bulk", 0);
+    queue.push("control", 10);
+    queue.push("normal", 5);
+    queue.push("bulk2", 0);
+
+    EXPECT_EQ(queue.size(), 4u);
+    EXPECT_EQ(queue.pop(), "control");
+    EXPECT_EQ(queue.pop(), "normal");
+    EXPECT_EQ(queue.pop(), "bulk");
+    EXPECT_EQ(queue.pop(), "bulk2");
+    EXPECT_TRUE(queue.empty());
+}
+
+TEST(ConcurrentPriorityQueueTest, PopEmpty)
+{
+    ConcurrentPriorityQueue<int> queue;
+    int                          value = 3;
+
+    EXPECT_FALSE(queue.try_pop(value));
+    EXPECT_EQ(value, 3);
+    EXPECT_THROW(queue.pop(), std::runtime_error);
+}
+
+TEST(ConcurrentPriorityQueueTest, UrgentElementsComeEarly)
+{
+    ConcurrentPriorityQueue<int> queue(8);
+
+    for (int i = 0; i < 1000; ++i)
+        queue.push(i, 0);
+    for (int i = 0; i < 10; ++i)
+        queue.push(-1, 100);
+
+    // Relaxed order: urgent work is not guaranteed first, but must not wait behind the bulk.
+    int urgentSeen = 0;
+    for (int i = 0; i < 200 && urgentSeen < 10; ++i)
+    {
+        if (queue.pop() == -1)
+            ++urgentSeen;
+    }
+    EXPECT_EQ(urgentSeen, 10);
+}
+
+TEST(ConcurrentPriorityQueueTest, ConcurrentProducersConsumers)
+{
+    ConcurrentPriorityQueue<int> queue;
+
+    const int producers_count    = 4;
+    const int items_per_producer = 10000;
+    const int total_items        = producers_count * items_per_producer;
+
+    std::atomic<int>       popped_count{0};
+    std::atomic<long long> popped_sum{0};
+
+    std::vector<std::thread> threads;
+    for (int p = 0; p < producers_count; ++p)
+    {
+        threads.emplace_back(
+            [p, &queue]()
+            {
+                for (int v = p * items_per_producer; v < (p + 1) * items_per_producer; ++v)
+                    queue.push(v, v % 7);
+            });
+    }
+    for (int c = 0; c < 4; ++c)
+    {
+        threads.emplace_back(
+            [&]()
+            {
+                int value;
+                while (popped_count.load() < total_items)
+                {
+                    if (queue.try_pop(value))
+                    {
+                        popped_sum.fetch_add(value);
+                        popped_count.fetch_add(1);
+                    }
+                }
+            });
+    }
+    for (auto& t : threads)
+        t.join();
+
+    EXPECT_EQ(popped_count.load(), total_items);
+    EXPECT_EQ(popped_sum.load(), (long long)(total_items - 1) * total_items / 2);
+    EXPECT_TRUE(queue.empty());
+}
@@ -0,0 +1,149 @@
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+#include "async_event.hpp"
+#include "async_mutex.hpp"
+#include "coroutine.hpp"
+#include "worker_pool.hpp"
+
+TEST(CoroutineTest, ScheduleMovesToWorker)
+{
+    WorkerPool pool(2);
+    auto       caller = std::this_thread::get_id();
+
+    auto task = [&]() -> Task<std::thread::id>
+    {
+        co_await pool.schedule();
+        co_return std::this_thread::get_id();
+    };
+
+    EXPECT_NE(syncWait(task()), caller);
+}
+
+TEST(CoroutineTest, AwaitNestedTasks)
+{
+    WorkerPool pool(2);
+
+    auto square = [&](int v) -> Task<int>
+    {
+        co_await pool.schedule();
+        co_return v * v;
+    };
+    auto sum = [&]() -> Task<int>
+    {
+        int total = 0;
+        for (int i = 1; i <= 10; ++i)
+            total += co_await square(i);
+        co_return total;
+    };
+
+    EXPECT_EQ(syncWait(sum()), 385);
+}
+
+TEST(CoroutineTest, ExceptionPropagates)
+{
+    WorkerPool pool(2);
+
+    auto failing = [&]() -> Task<void>
+    {
+        co_await pool.schedule();
+        throw std::runtime_error("boom");
+    };
+
+    EXPECT_THROW(syncWait(failing()), std::runtime_error);
+}
+
+TEST(CoroutineTest, WhenAllMultiplexesThousandsOfTasks)
+{
+    WorkerPool pool(3);
+
+    auto work = [&](int v) -> Task<int>
+    {
+        co_await pool.schedule();
+        co_return v * 2;
+    };
+
+    std::vector<Task<int>> tasks;
+    for (int i = 0; i < 10000; ++i)
+        tasks.push_back(work(i));
+
+    std::vector<int> results = syncWait(whenAll(std::move(tasks)));
+    ASSERT_EQ(results.size(), 10000u);
+    for (int i = 0; i < 10000; ++i)
+        EXPECT_EQ(results[i], i * 2);
+}
+
+TEST(CoroutineTest, AwaitSubmittedFuture)
+{
+    WorkerPool pool({.workerCount = 2, .scheduling = WorkerPool::Scheduling::WorkStealing});
+
+    auto task = [&]() -> Task<int>
+    {
+        int a = co_await pool.submit([] { return 20; });
+        int b = co_await pool.submit([](int v) { return v + 2; }, a);
+        co_return b;
+    };
+
+    EXPECT_EQ(syncWait(task()), 22);
+}
+
+TEST(CoroutineTest, AsyncMutexSerializes)
+{
+    WorkerPool pool(4);
+    AsyncMutex mutex;
+    int        counter = 0;
+
+    auto increment = [&]() -> Task<void>
+    {
+        co_await pool.schedule();
+        for (int i = 0; i < 100; ++i)
+        {
+            auto lock = co_await mutex.scopedLockAsync();
+            ++counter;
+        }
+    };
+
+    std::vector<Task<void>> tasks;
+    for (int i = 0; i < 200; ++i)
+        tasks.push_back(increment());
+    syncWait(whenAll(std::move(tasks)));
+
+    EXPECT_EQ(counter, 20000);
+    EXPECT_TRUE(mutex.tryLock());
+    mutex.unlock();
+}
+
+TEST(CoroutineTest, AsyncEventReleasesWaiters)
+{
+    WorkerPool       pool(2);
+    AsyncEvent       event;
+    std::atomic<int> woken{0};
+
+    auto waiter = [&]() -> Task<void>
+    {
+        co_await pool.schedule();
+        co_await event;
+        woken.fetch_add(1);
+    };
+    auto setter = [&]() -> Task<void>
+    {
+        co_await pool.schedule();
+        event.set();
+        co_return;
+    };
+
+    std::vector<Task<void>> tasks;
+    for (int i = 0; i < 100; ++i)
+        tasks.push_back(waiter());
+    tasks.push_back(setter());
+    syncWait(whenAll(std::move(tasks)));
+
+    EXPECT_EQ(woken.load(), 100);
+    EXPECT_TRUE(event.isSet());
+    event.reset();
+    EXPECT_FALSE(event.isSet());
+}
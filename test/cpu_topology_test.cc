@@ -0,0 +1,51 @@
+#include <gtest/gtest.h>
+
+#include <sched.h>
+
+#include <set>
+#include <vector>
+
+#include "cpu_topology.hpp"
+
+TEST(CpuTopologyTest, ParseCpuList)
+{
+    EXPECT_EQ(CpuTopology::parseCpuList("0-3,8,10-11"),
+              (std::vector<int>{0, 1, 2, 3, 8, 10, 11}));
+    EXPECT_EQ(CpuTopology::parseCpuList("5"), (std::vector<int>{5}));
+    EXPECT_TRUE(CpuTopology::parseCpuList("").empty());
+    EXPECT_EQ(CpuTopology::parseCpuList(" 2 ,x,4-y,-3,6-7\n"), (std::vector<int>{2, 6, 7}));
+    EXPECT_TRUE(CpuTopology::parseCpuList("99999999999").empty());
+}
+
+TEST(CpuTopologyTest, CoresFirstSpreadsBeforeSiblings)
+{
+    // Two caches of two cores, two SMT threads per core: CPU n and n + 4 are siblings.
+    std::vector<CpuTopology::Cpu> cpus = {
+        {0, 0, 0, 0}, {4, 0, 0, 0}, {1, 1, 0, 0}, {5, 1, 0, 0},
+        {2, 2, 2, 0}, {6, 2, 2, 0}, {3, 3, 2, 0}, {7, 3, 2, 0},
+    };
+    std::vector<int> ids;
+    for (const CpuTopology::Cpu& cpu : CpuTopology::coresFirst(cpus))
+        ids.push_back(cpu.id);
+    EXPECT_EQ(ids, (std::vector<int>{0, 1, 2, 3, 4, 5, 6, 7}));
+    EXPECT_TRUE(CpuTopology::coresFirst({}).empty());
+}
+
+TEST(CpuTopologyTest, MatchesAffinityMask)
+{
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    ASSERT_EQ(sched_getaffinity(0, sizeof(set), &set), 0);
+
+    CpuTopology   topology;
+    std::set<int> ids;
+    for (const CpuTopology::Cpu& cpu : topology.cpus())
+    {
+        EXPECT_TRUE(CPU_ISSET(cpu.id, &set));
+        EXPECT_LE(cpu.core, cpu.id);
+        ids.insert(cpu.id);
+    }
+    EXPECT_EQ(ids.size(), static_cast<size_t>(CPU_COUNT(&set)));
+    EXPECT_GE(topology.coreCount(), topology.cacheCount());
+    EXPECT_LE(topology.coreCount(), topology.cpus().size());
+}
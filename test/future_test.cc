@@ -0,0 +1,58 @@
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <future>
+#include <stdexcept>
+#include <string>
+#include <thread>
+
+#include "future.hpp"
+
+TEST(FutureTest, ValueAcrossThreads)
+{
+    Promise<std::string> promise;
+    Future<std::string>  future = promise.getFuture();
+
+    std::thread producer(
+        [&promise]()
+        {
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+            promise.setValue("done");
+        });
+
+    EXPECT_EQ(future.get(), "done");
+    EXPECT_FALSE(future.valid());
+    producer.join();
+}
+
+TEST(FutureTest, Exception)
+{
+    Promise<int> promise;
+    Future<int>  future = promise.getFuture();
+
+    promise.setException(std::make_exception_ptr(std::runtime_error("boom")));
+    EXPECT_TRUE(future.ready());
+    EXPECT_THROW(future.get(), std::runtime_error);
+}
+
+TEST(FutureTest, BrokenPromise)
+{
+    Future<void> future;
+    {
+        Promise<void> promise;
+        future = promise.getFuture();
+    }
+    EXPECT_THROW(future.get(), std::future_error);
+}
+
+TEST(FutureTest, Misuse)
+{
+    Promise<int> promise;
+    Future<int>  future = promise.getFuture();
+
+    EXPECT_THROW(promise.getFuture(), std::future_error);
+    promise.setValue(1);
+    EXPECT_THROW(promise.setValue(2), std::future_error);
+    EXPECT_EQ(future.get(), 1);
+    EXPECT_THROW(future.get(), std::future_error);
+}
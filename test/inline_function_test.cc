@@ -0,0 +1,61 @@
+#include <gtest/gtest.h>
+
+#include <array>
+#include <functional>
+#include <memory>
+#include <string>
+
+#include "inline_function.hpp"
+
+TEST(InlineFunctionTest, Invoke)
+{
+    InlineFunction<int(int, int)> add = [](int a, int b) { return a + b; };
+
+    EXPECT_TRUE(static_cast<bool>(add));
+    EXPECT_EQ(add(2, 3), 5);
+}
+
+TEST(InlineFunctionTest, MoveOnlyCapture)
+{
+    auto                    value = std::make_unique<std::string>("moved");
+    InlineFunction<std::string()> func =
+        [value = std::move(value)]() { return *value; };
+
+    InlineFunction<std::string()> other = std::move(func);
+    EXPECT_FALSE(static_cast<bool>(func));
+    EXPECT_EQ(other(), "moved");
+}
+
+TEST(InlineFunctionTest, SmallCallablesStayInline)
+{
+    auto small = [a = 1, b = 2]() { return a + b; };
+    auto big   = [buffer = std::array<char, 256>{}]() { return buffer[0]; };
+
+    EXPECT_TRUE(InlineFunction<int()>::storesInline<decltype(small)>);
+    EXPECT_FALSE(InlineFunction<int()>::storesInline<decltype(big)>);
+
+    InlineFunction<int()> heap = big;
+    EXPECT_EQ(heap(), 0);
+}
+
+TEST(InlineFunctionTest, DestroysCapture)
+{
+    auto shared = std::make_shared<int>(1);
+    {
+        InlineFunction<void()> func = [shared]() {};
+        EXPECT_EQ(shared.use_count(), 2);
+        func = nullptr;
+        EXPECT_EQ(shared.use_count(), 1);
+        func = [shared]() {};
+        EXPECT_EQ(shared.use_count(), 2);
+    }
+    EXPECT_EQ(shared.use_count(), 1);
+}
+
+TEST(InlineFunctionTest, EmptyThrows)
+{
+    InlineFunction<void()> func;
+
+    EXPECT_FALSE(static_cast<bool>(func));
+    EXPECT_THROW(func(), std::bad_function_call);
+}
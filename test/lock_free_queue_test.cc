@@ -0,0 +1,236 @@
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "lock_free_queue.hpp"
+
+namespace
+{
+template <typename TType>
+struct CountingAllocator
+{
+    using value_type = TType;
+
+    std::atomic<size_t>* allocations;
+
+    explicit CountingAllocator(std::atomic<size_t>* counter) : allocations(counter) {}
+
+    template <typename TOther>
+    CountingAllocator(const CountingAllocator<TOther>& other) : allocations(other.allocations)
+    {
+    }
+
+    TType* allocate(size_t count)
+    {
+        allocations->fetch_add(count);
+        return std::allocator<TType>().allocate(count);
+    }
+
+    void deallocate(TType* pointer, size_t count)
+    {
+        std::allocator<TType>().deallocate(pointer, count);
+    }
+
+    bool operator==(const CountingAllocator& other) const
+    {
+        return allocations == other.allocations;
+    }
+};
+
+struct ThrowingCopy
+{
+    bool fail;
+
+    explicit ThrowingCopy(bool fail) : fail(fail) {}
+    ThrowingCopy(const ThrowingCopy& other) : fail(other.fail)
+    {
+        if (fail)
+            throw std::runtime_error("copy");
+    }
+    ThrowingCopy& operator=(const ThrowingCopy&) noexcept = default;
+};
+} // namespace
+
+TEST(LockFreeQueueTest, BasicOperations)
+{
+    LockFreeQueue<int> queue;
+
+    EXPECT_TRUE(queue.empty());
+    queue.push_back(1);
+    queue.push_back(2);
+    queue.push_back(3);
+    EXPECT_FALSE(queue.empty());
+
+    EXPECT_EQ(queue.pop_front(), 1);
+    EXPECT_EQ(queue.pop_front(), 2);
+    EXPECT_EQ(queue.pop_front(), 3);
+    EXPECT_TRUE(queue.empty());
+}
+
+TEST(LockFreeQueueTest, PopEmpty)
+{
+    LockFreeQueue<int> queue;
+    int                value = 42;
+
+    EXPECT_FALSE(queue.try_pop_front(value));
+    EXPECT_EQ(value, 42);
+    EXPECT_THROW(queue.pop_front(), std::runtime_error);
+}
+
+TEST(LockFreeQueueTest, NonTrivialType)
+{
+    LockFreeQueue<std::string> queue;
+
+    queue.push_back(std::string(64, 'a'));
+    queue.push_back("b");
+
+    std::string out;
+    EXPECT_TRUE(queue.try_pop_front(out));
+    EXPECT_EQ(out, std::string(64, 'a'));
+}
+
+TEST(LockFreeQueueTest, DestructorReleasesRemainingElements)
+{
+    auto shared = std::make_shared<int>(7);
+    {
+        LockFreeQueue<std::shared_ptr<int>> queue;
+        for (int i = 0; i < 10; ++i)
+            queue.push_back(shared);
+        std::shared_ptr<int> out;
+        queue.try_pop_front(out);
+    }
+    EXPECT_EQ(shared.use_count(), 1);
+}
+
+TEST(LockFreeQueueTest, SteadyStateDoesNotAllocate)
+{
+    std::atomic<size_t>                        allocations(0);
+    LockFreeQueue<int, CountingAllocator<int>> queue{CountingAllocator<int>(&allocations)};
+
+    // Keep a few elements queued and cycle long enough for retired nodes to be recycled.
+    auto cycle = [&](int rounds)
+    {
+        int value;
+        for (int i = 0; i < rounds; ++i)
+        {
+            queue.push_back(i);
+            EXPECT_TRUE(queue.try_pop_front(value));
+        }
+    };
+    for (int i = 0; i < 8; ++i)
+        queue.push_back(i);
+    cycle(10000);
+
+    size_t warm = allocations.load();
+    EXPECT_GT(warm, 0u);
+    cycle(100000);
+    EXPECT_EQ(allocations.load(), warm);
+}
+
+TEST(LockFreeQueueTest, ThrowingConstructorDoesNotLeakNodes)
+{
+    std::atomic<size_t> allocations(0);
+    LockFreeQueue<ThrowingCopy, CountingAllocator<ThrowingCopy>> queue{
+        CountingAllocator<ThrowingCopy>(&allocations)};
+
+    ThrowingCopy failing(true);
+    for (int i = 0; i < 10000; ++i)
+        EXPECT_THROW(queue.push_back(failing), std::runtime_error);
+    // The nodes went back through the retired list and were reused.
+    EXPECT_LT(allocations.load(), 1000u);
+
+    queue.push_back(ThrowingCopy(false));
+    ThrowingCopy out(true);
+    EXPECT_TRUE(queue.try_pop_front(out));
+    EXPECT_FALSE(out.fail);
+    EXPECT_TRUE(queue.empty());
+}
+
+TEST(LockFreeQueueTest, MultipleProducersMultipleConsumers)
+{
+    LockFreeQueue<int> queue;
+
+    const int producers_count    = 4;
+    const int consumers_count    = 4;
+    const int items_per_producer = 20000;
+    const int total_items        = producers_count * items_per_producer;
+
+    std::atomic<int>       popped_count{0};
+    std::atomic<long long> popped_sum{0};
+    long long              expected_sum = (long long)(total_items - 1) * total_items / 2;
+
+    std::vector<std::thread> threads;
+    for (int p = 0; p < producers_count; ++p)
+    {
+        threads.emplace_back(
+            [p, &queue]()
+            {
+                for (int v = p * items_per_producer; v < (p + 1) * items_per_producer; ++v)
+                    queue.push_back(v);
+            });
+    }
+    for (int c = 0; c < consumers_count; ++c)
+    {
+        threads.emplace_back(
+            [&]()
+            {
+                int value;
+                while (popped_count.load() < total_items)
+                {
+                    if (queue.try_pop_front(value))
+                    {
+                        popped_sum.fetch_add(value);
+                        popped_count.fetch_add(1);
+                    }
+                    else
+                    {
+                        std::this_thread::yield();
+                    }
+                }
+            });
+    }
+    for (auto& t : threads)
+        t.join();
+
+    EXPECT_EQ(popped_count.load(), total_items);
+    EXPECT_EQ(popped_sum.load(), expected_sum);
+    EXPECT_TRUE(queue.empty());
+}
+
+TEST(LockFreeQueueTest, FifoPerProducer)
+{
+    LockFreeQueue<std::pair<int, int>> queue;
+
+    const int producers_count    = 3;
+    const int items_per_producer = 10000;
+
+    std::vector<std::thread> producers;
+    for (int p = 0; p < producers_count; ++p)
+    {
+        producers.emplace_back(
+            [p, &queue]()
+            {
+                for (int i = 0; i < items_per_producer; ++i)
+                    queue.push_back({p, i});
+            });
+    }
+
+    std::vector<int>    last(producers_count, -1);
+    int                 received = 0;
+    std::pair<int, int> item;
+    while (received < producers_count * items_per_producer)
+    {
+        if (!queue.try_pop_front(item))
+            continue;
+        EXPECT_GT(item.second, last[item.first]);
+        last[item.first] = item.second;
+        ++received;
+    }
+    for (auto& t : producers)
+        t.join();
+}
@@ -0,0 +1,268 @@
+#include <gtest/gtest.h>
+
+#include <unistd.h>
+
+#include <algorithm>
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <system_error>
+#include <thread>
+#include <vector>
+
+#include "log_sink.hpp"
+#include "thread_safe_iostream.hpp"
+
+namespace
+{
+class LogSinkTest : public ::testing::Test
+{
+protected:
+    std::filesystem::path dir;
+
+    void SetUp() override
+    {
+        const ::testing::TestInfo* test = ::testing::UnitTest::GetInstance()->current_test_info();
+        dir = std::filesystem::temp_directory_path()
+              / ("libftpp_" + std::to_string(getpid()) + "_" + test->name());
+        std::filesystem::remove_all(dir);
+        std::filesystem::create_directories(dir);
+    }
+
+    void TearDown() override
+    {
+        ThreadSafeIOStream::clearSinks();
+        std::filesystem::remove_all(dir);
+    }
+
+    std::string file(const std::string& name) const
+    {
+        return (dir / name).string();
+    }
+};
+
+std::string readFile(const std::string& path)
+{
+    std::ifstream      in(path, std::ios::binary);
+    std::ostringstream content;
+    content << in.rdbuf();
+    return content.str();
+}
+
+std::string numberedLines(size_t first, size_t count)
+{
+    std::string text;
+    for (size_t i = first; i < first + count; ++i)
+        text += "line " + std::to_string(i) + "\n";
+    return text;
+}
+} // namespace
+
+TEST_F(LogSinkTest, FileSinkReceivesTheLines)
+{
+    auto sink = std::make_shared<FileSink>(file("app.log"));
+    ThreadSafeIOStream::addSink(sink);
+    ThreadSafeIO.setPrefix("[sink] ");
+
+    ThreadSafeIO << "synchronous" << std::endl;
+    ThreadSafeIOStream::enableAsync();
+    ThreadSafeIO << "asynchronous " << 42 << std::endl;
+    ThreadSafeIO.log<"deferred {}">(1.5);
+    ThreadSafeIOStream::sync();
+    ThreadSafeIOStream::disableAsync();
+
+    EXPECT_EQ(readFile(file("app.log")),
+              "[sink] synchronous\n[sink] asynchronous 42\n[sink] deferred 1.5\n");
+}
+
+TEST_F(LogSinkTest, AppendsToAnExistingFile)
+{
+    std::ofstream(file("app.log")) << "before\n";
+    FileSink sink(file("app.log"));
+    sink.write("after\n");
+    sink.sync();
+    EXPECT_EQ(readFile(file("app.log")), "before\nafter\n");
+}
+
+TEST_F(LogSinkTest, BatchesLargerThanTheBuffers)
+{
+    FileSink::Options options;
+    options.bufferSize = 4096;
+    options.buffers    = 2;
+    FileSink sink(file("app.log"), options);
+
+    std::string expected = numberedLines(0, 20000);
+    for (size_t i = 0; i < 20000; ++i)
+        sink.write("line " + std::to_string(i) + "\n");
+    sink.sync();
+    EXPECT_EQ(readFile(file("app.log")), expected);
+    EXPECT_EQ(sink.lastError(), 0);
+}
+
+TEST_F(LogSinkTest, FlushesPartialBuffersOnItsOwn)
+{
+    FileSink::Options options;
+    options.flushInterval = std::chrono::milliseconds(5);
+    FileSink sink(file("app.log"), options);
+    sink.write("idle\n");
+
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+    while (readFile(file("app.log")).empty() && std::chrono::steady_clock::now() < deadline)
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    EXPECT_EQ(readFile(file("app.log")), "idle\n");
+}
+
+TEST_F(LogSinkTest, RotatesOnSize)
+{
+    FileSink::Options options;
+    options.bufferSize  = 4096;
+    options.maxFileSize = 4096;
+    options.keepFiles   = 3;
+    {
+        FileSink sink(file("app.log"), options);
+        for (size_t i = 0; i < 5000; ++i)
+        {
+            sink.write("line " + std::to_string(i) + "\n");
+            if (i % 100 == 99)
+                sink.sync();
+        }
+        sink.sync();
+        EXPECT_GT(sink.rotations(), 3u);
+        EXPECT_EQ(sink.lastError(), 0);
+    }
+
+    EXPECT_FALSE(std::filesystem::exists(file("app.log.4")));
+    std::string kept = readFile(file("app.log.3")) + readFile(file("app.log.2"))
+                       + readFile(file("app.log.1")) + readFile(file("app.log"));
+    // A file is rotated after the batch that crosses the limit, not in the middle of it.
+    EXPECT_LE(readFile(file("app.log.1")).size(), 2 * options.maxFileSize);
+    // The oldest lines were dropped with the files beyond keepFiles; the rest is whole.
+    std::string all = numberedLines(0, 5000);
+    ASSERT_FALSE(kept.empty());
+    EXPECT_EQ(all.substr(all.size() - kept.size()), kept);
+    EXPECT_EQ(kept.substr(0, 5), "line ");
+}
+
+TEST_F(LogSinkTest, RotatesOnTime)
+{
+    FileSink::Options options;
+    options.flushInterval  = std::chrono::milliseconds(5);
+    options.rotateInterval = std::chrono::milliseconds(20);
+    FileSink sink(file("app.log"), options);
+
+    sink.write("old\n");
+    sink.sync();
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+    while (sink.rotations() == 0 && std::chrono::steady_clock::now() < deadline)
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    sink.write("new\n");
+    sink.sync();
+
+    EXPECT_EQ(sink.rotations(), 1u);
+    EXPECT_EQ(readFile(file("app.log.1")), "old\n");
+    EXPECT_EQ(readFile(file("app.log")), "new\n");
+}
+
+TEST_F(LogSinkTest, FailedRotationReopensWithoutRotatingAgain)
+{
+    FileSink::Options options;
+    options.flushInterval = std::chrono::minutes(1);
+    options.maxFileSize   = 8;
+    FileSink sink(file("app.log"), options);
+
+    // Neither the renames nor the new file can succeed without the directory.
+    sink.write("lost line\n");
+    std::filesystem::remove_all(dir);
+    sink.sync();
+    EXPECT_EQ(sink.rotations(), 1u);
+    EXPECT_EQ(sink.lastError(), ENOENT);
+
+    std::filesystem::create_directories(dir);
+    sink.write("kept\n");
+    sink.sync();
+    sink.write("kept\n");
+    sink.sync();
+    EXPECT_EQ(sink.rotations(), 2u);
+    EXPECT_EQ(readFile(file("app.log")), "");
+    EXPECT_EQ(readFile(file("app.log.1")), "kept\nkept\n");
+}
+
+TEST_F(LogSinkTest, DirectIOKeepsTheExactContent)
+{
+    std::ofstream(file("app.log")) << "kept\n";
+    FileSink::Options options;
+    options.bufferSize = 8192;
+    options.directIO   = true;
+    options.dataSync   = true;
+
+    std::string expected = "kept\n";
+    {
+        FileSink sink(file("app.log"), options);
+        for (size_t i = 0; i < 3000; ++i)
+        {
+            std::string line = "line " + std::to_string(i) + "\n";
+            expected += line;
+            sink.write(line);
+            if (i % 1000 == 0)
+            {
+                // A synced tail is rewritten along with what follows it.
+                sink.sync();
+                EXPECT_EQ(readFile(file("app.log")), expected);
+            }
+        }
+        EXPECT_EQ(sink.lastError(), 0);
+    }
+    EXPECT_EQ(readFile(file("app.log")), expected);
+}
+
+TEST_F(LogSinkTest, SinksWriteInParallel)
+{
+    auto first  = std::make_shared<FileSink>(file("first.log"));
+    auto second = std::make_shared<FileSink>(file("second.log"));
+    ThreadSafeIOStream::addSink(first);
+    ThreadSafeIOStream::addSink(second);
+    ThreadSafeIO.setPrefix("");
+
+    ThreadSafeIOStream::enableAsync();
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 4; ++t)
+        threads.emplace_back(
+            [t]
+            {
+                for (int i = 0; i < 500; ++i)
+                    ThreadSafeIO.log<"thread {} line {}">(t, i);
+            });
+    for (std::thread& thread : threads)
+        thread.join();
+    ThreadSafeIOStream::sync();
+    ThreadSafeIOStream::disableAsync();
+
+    std::string content = readFile(file("first.log"));
+    EXPECT_EQ(std::count(content.begin(), content.end(), '\n'), 2000);
+    EXPECT_EQ(readFile(file("second.log")), content);
+}
+
+TEST_F(LogSinkTest, ClearSinksGoesBackToCout)
+{
+    auto sink = std::make_shared<FileSink>(file("app.log"));
+    ThreadSafeIOStream::addSink(sink);
+    ThreadSafeIO.setPrefix("");
+    ThreadSafeIO << "to file" << std::endl;
+    ThreadSafeIOStream::clearSinks();
+
+    std::ostringstream captured;
+    std::streambuf*    old = std::cout.rdbuf(captured.rdbuf());
+    ThreadSafeIO << "to cout" << std::endl;
+    std::cout.rdbuf(old);
+
+    EXPECT_EQ(readFile(file("app.log")), "to file\n");
+    EXPECT_EQ(captured.str(), "to cout\n");
+}
+
+TEST_F(LogSinkTest, OpenFailureThrows)
+{
+    EXPECT_THROW(FileSink(file("missing/app.log")), std::system_error);
+}
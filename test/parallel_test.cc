@@ -0,0 +1,150 @@
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <atomic>
+#include <memory>
+#include <numeric>
+#include <random>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+#include "latch.hpp"
+#include "parallel.hpp"
+#include "worker_pool.hpp"
+
+TEST(ParallelTest, LatchCanBeFreedAsSoonAsItOpens)
+{
+    // The waiter destroys the latch the moment it opens; the counter must be done with it.
+    for (int i = 0; i < 2000; ++i)
+    {
+        auto        latch = std::make_unique<Latch>(1);
+        std::thread counter([raw = latch.get()] { raw->countDown(); });
+        if (i % 2)
+            latch->wait();
+        else
+            while (!latch->tryWait())
+                std::this_thread::yield();
+        latch.reset();
+        counter.join();
+    }
+}
+
+TEST(ParallelTest, ForVisitsEveryIndexOnce)
+{
+    WorkerPool             pool(4);
+    std::vector<int>       hits(100000, 0);
+    std::atomic<long long> sum{0};
+
+    parallel_for(pool,
+                 0,
+                 static_cast<int>(hits.size()),
+                 [&](int i)
+                 {
+                     hits[i]++;
+                     sum.fetch_add(i, std::memory_order_relaxed);
+                 });
+
+    EXPECT_TRUE(std::all_of(hits.begin(), hits.end(), [](int h) { return h == 1; }));
+    EXPECT_EQ(sum.load(), (long long)(hits.size() - 1) * hits.size() / 2);
+}
+
+TEST(ParallelTest, ForEmptyAndTinyRanges)
+{
+    WorkerPool pool(2);
+    int        calls = 0;
+
+    parallel_for(pool, 5, 5, [&](int) { ++calls; });
+    EXPECT_EQ(calls, 0);
+    parallel_for(pool, 0, 3, [&](int) { ++calls; }, 16);
+    EXPECT_EQ(calls, 3);
+}
+
+TEST(ParallelTest, ForRethrowsBodyException)
+{
+    WorkerPool pool(4);
+
+    EXPECT_THROW(parallel_for(
+                     pool,
+                     0,
+                     10000,
+                     [](int i)
+                     {
+                         if (i == 5000)
+                             throw std::runtime_error("bad index");
+                     },
+                     10),
+                 std::runtime_error);
+    EXPECT_TRUE(pool.getExceptions().empty());
+}
+
+TEST(ParallelTest, Reduce)
+{
+    WorkerPool pool({.workerCount = 4, .scheduling = WorkerPool::Scheduling::WorkStealing});
+    std::vector<long long> values(1 << 18);
+    std::iota(values.begin(), values.end(), 1);
+
+    long long sum = parallel_reduce(
+        pool, values.begin(), values.end(), 0LL, [](long long a, long long b) { return a + b; });
+    EXPECT_EQ(sum, std::accumulate(values.begin(), values.end(), 0LL));
+
+    long long max = parallel_reduce(pool,
+                                    values.begin(),
+                                    values.end(),
+                                    0LL,
+                                    [](long long a, long long b) { return std::max(a, b); });
+    EXPECT_EQ(max, 1 << 18);
+}
+
+TEST(ParallelTest, Transform)
+{
+    WorkerPool       pool(3);
+    std::vector<int> in(50000);
+    std::vector<int> out(in.size());
+    std::iota(in.begin(), in.end(), 0);
+
+    auto end =
+        parallel_transform(pool, in.begin(), in.end(), out.begin(), [](int v) { return v * 3; });
+
+    EXPECT_EQ(end, out.end());
+    for (size_t i = 0; i < in.size(); ++i)
+        ASSERT_EQ(out[i], in[i] * 3);
+}
+
+TEST(ParallelTest, Sort)
+{
+    WorkerPool       pool(4);
+    std::vector<int> values(300000);
+    std::mt19937     rng(7);
+    for (auto& v : values)
+        v = static_cast<int>(rng() % 1000);
+    std::vector<int> expected = values;
+    std::sort(expected.begin(), expected.end(), std::greater<>());
+
+    parallel_sort(pool, values.begin(), values.end(), std::greater<>(), 1024);
+    EXPECT_EQ(values, expected);
+}
+
+TEST(ParallelTest, NestedInsideJob)
+{
+    WorkerPool       pool(2);
+    std::vector<int> values(10000, 1);
+
+    // Every worker is busy in an outer task that itself runs a parallel loop.
+    std::vector<Future<long long>> outer;
+    for (int i = 0; i < 4; ++i)
+    {
+        outer.push_back(pool.submit(
+            [&pool, &values]()
+            {
+                return parallel_reduce(pool,
+                                       values.begin(),
+                                       values.end(),
+                                       0LL,
+                                       [](long long a, long long b) { return a + b; },
+                                       100);
+            }));
+    }
+    for (auto& f : outer)
+        EXPECT_EQ(f.get(), 10000);
+}
@@ -1,7 +1,31 @@
 #include <gtest/gtest.h>
 
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
 #include "persistent_worker.hpp"
 
+namespace
+{
+// Generous on purpose: a loaded machine may run the tasks late, but not never.
+bool waitFor(const std::function<bool()>& condition)
+{
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+    while (!condition())
+    {
+        if (std::chrono::steady_clock::now() > deadline)
+            return false;
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    return true;
+}
+} // namespace
+
 TEST(PersistentWorkerTest, AddAndRemoveTask)
 {
     PersistentWorker worker(std::chrono::milliseconds(10));
@@ -68,3 +92,258 @@ TEST(PersistentWorkerTest, MultipleTasks)
     EXPECT_EQ(counter1, oldCounter1); // task1 should not increment anymore
     EXPECT_GT(counter2, oldCounter2); // task2 should still increment
 }
+
+TEST(PersistentWorkerTest, PerTaskIntervalAndDelay)
+{
+    PersistentWorker worker(std::chrono::milliseconds(1));
+
+    std::atomic<int> fast{0};
+    std::atomic<int> slow{0};
+    std::atomic<int> delayed{0};
+
+    worker.addTask("fast", [&] { fast++; }, std::chrono::milliseconds(2));
+    worker.addTask("slow", [&] { slow++; }, std::chrono::milliseconds(100));
+    worker.addTask(
+        "delayed", [&] { delayed++; }, std::chrono::milliseconds(1), std::chrono::seconds(10));
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(250));
+
+    EXPECT_GT(fast.load(), 10);
+    EXPECT_GE(slow.load(), 1);
+    EXPECT_LE(slow.load(), 3);
+    EXPECT_EQ(delayed.load(), 0);
+}
+
+TEST(PersistentWorkerTest, ReplacingTaskKeepsOneSchedule)
+{
+    PersistentWorker worker(std::chrono::milliseconds(1));
+
+    std::atomic<int> first{0};
+    std::atomic<int> second{0};
+    worker.addTask("task", [&] { first++; }, std::chrono::milliseconds(1));
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    worker.addTask("task", [&] { second++; }, std::chrono::milliseconds(1));
+    int seen = first.load();
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    EXPECT_LE(first.load(), seen + 1);
+    EXPECT_GT(second.load(), 0);
+}
+
+TEST(PersistentWorkerTest, ChurnWhileRunning)
+{
+    PersistentWorker worker(std::chrono::milliseconds(1));
+
+    std::atomic<int> kept{0};
+    std::atomic<int> removed{0};
+    worker.addTask("kept", [&] { kept++; });
+
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 4; ++t)
+    {
+        threads.emplace_back(
+            [&worker, t]
+            {
+                for (int i = 0; i < 200; ++i)
+                {
+                    std::string name = "churn" + std::to_string(t) + "_" + std::to_string(i % 8);
+                    worker.addTask(name, [] {});
+                    if (i % 2)
+                        worker.removeTask(name);
+                }
+            });
+    }
+    worker.addTask("removed", [&] { removed++; });
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    worker.removeTask("removed");
+    // Only a run already in progress may still finish.
+    int seen = removed.load();
+
+    for (auto& thread : threads)
+        thread.join();
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+
+    EXPECT_GT(kept.load(), 0);
+    EXPECT_LE(removed.load(), seen + 1);
+}
+
+TEST(PersistentWorkerTest, ShardsSpreadTasksAndRunInParallel)
+{
+    PersistentWorker worker({.threads = 4});
+    EXPECT_EQ(worker.threadCount(), 4u);
+
+    std::atomic<int>  fast{0};
+    std::atomic<bool> release{false};
+    worker.addTask("slow",
+                   [&]
+                   {
+                       while (!release.load())
+                           std::this_thread::sleep_for(std::chrono::milliseconds(1));
+                   });
+    worker.addTask("fast", [&] { fast++; });
+    for (int i = 0; i < 6; ++i)
+        worker.addTask("idle" + std::to_string(i), [] {});
+
+    std::vector<int> perShard(4, 0);
+    for (const char* name : {"slow", "fast", "idle0", "idle1", "idle2", "idle3", "idle4", "idle5"})
+        perShard[worker.shardOf(name)]++;
+    for (int count : perShard)
+        EXPECT_EQ(count, 2);
+    EXPECT_NE(worker.shardOf("slow"), worker.shardOf("fast"));
+
+    // The slow task holds its own shard only.
+    EXPECT_TRUE(waitFor([&] { return fast.load() > 5; }));
+    release.store(true);
+}
+
+TEST(PersistentWorkerTest, RemovalRebalancesShards)
+{
+    PersistentWorker worker({.threads = 2});
+
+    std::atomic<int> moved{0};
+    worker.addTask("a", [] {});
+    worker.addTask("b", [&] { moved++; });
+    worker.addTask("c", [] {});
+    worker.addTask("d", [&] { moved++; });
+    ASSERT_EQ(worker.shardOf("a"), worker.shardOf("c"));
+    ASSERT_EQ(worker.shardOf("b"), worker.shardOf("d"));
+
+    worker.removeTask("a");
+    worker.removeTask("c");
+    EXPECT_NE(worker.shardOf("b"), worker.shardOf("d"));
+
+    int seen = moved.load();
+    EXPECT_TRUE(waitFor([&] { return moved.load() > seen + 10; }));
+}
+
+TEST(PersistentWorkerTest, PinnedAndHashedPlacement)
+{
+    PersistentWorker worker({.threads = 3, .placement = PersistentWorker::Placement::Hash});
+
+    worker.addTask("pinned", [] {}, {.shard = 2});
+    EXPECT_EQ(worker.shardOf("pinned"), 2u);
+    EXPECT_THROW(worker.addTask("bad", [] {}, {.shard = 3}), std::out_of_range);
+    EXPECT_THROW(worker.shardOf("bad"), std::out_of_range);
+
+    worker.addTask("x", [] {});
+    worker.addTask("y", [] {});
+    size_t x = worker.shardOf("x");
+    worker.removeTask("y");
+    worker.addTask("x", [] {});
+    EXPECT_EQ(worker.shardOf("x"), x);
+}
+
+TEST(PersistentWorkerTest, FixedRateHoldsItsPeriod)
+{
+    PersistentWorker worker({.threads = 2});
+    auto             work = [] { std::this_thread::sleep_for(std::chrono::milliseconds(6)); };
+
+    worker.addTask("delay", work, {.interval = std::chrono::milliseconds(10), .shard = 0});
+    worker.addTask("rate",
+                   work,
+                   {.interval = std::chrono::milliseconds(10),
+                    .shard    = 1,
+                    .schedule = PersistentWorker::Schedule::FixedRate,
+                    .stats    = true});
+    ASSERT_TRUE(waitFor([&] { return worker.taskStats("delay").runs >= 20; }));
+
+    PersistentWorker::TaskStats delay = worker.taskStats("delay");
+    PersistentWorker::TaskStats rate  = worker.taskStats("rate");
+    // 16 ms per period against 10 ms; a slow machine stretches both alike.
+    EXPECT_GT(rate.runs, delay.runs);
+    // A run may be in progress while the stats are read.
+    EXPECT_NEAR(rate.execution.count(), rate.runs, 1);
+    EXPECT_NEAR(rate.jitter.count(), rate.runs, 1);
+    EXPECT_GE(rate.execution.max(), std::chrono::milliseconds(6));
+    EXPECT_EQ(delay.execution.count(), 0u);
+}
+
+TEST(PersistentWorkerTest, OverrunPolicies)
+{
+    PersistentWorker worker({.threads = 2});
+
+    auto stall = [](std::atomic<int>& runs)
+    {
+        return [&runs]
+        {
+            if (runs++ == 0)
+                std::this_thread::sleep_for(std::chrono::milliseconds(55));
+        };
+    };
+    std::atomic<int> caught{0};
+    std::atomic<int> skipped{0};
+    worker.addTask("catchUp",
+                   stall(caught),
+                   {.interval = std::chrono::milliseconds(10),
+                    .shard    = 0,
+                    .schedule = PersistentWorker::Schedule::FixedRate});
+    worker.addTask("skip",
+                   stall(skipped),
+                   {.interval = std::chrono::milliseconds(10),
+                    .shard    = 1,
+                    .schedule = PersistentWorker::Schedule::FixedRate,
+                    .overrun  = PersistentWorker::Overrun::Skip});
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+
+    PersistentWorker::TaskStats catchUp = worker.taskStats("catchUp");
+    PersistentWorker::TaskStats skip    = worker.taskStats("skip");
+    // Catching up runs once per deadline; skipping drops the five that passed during the stall.
+    EXPECT_GE(catchUp.runs, 9u);
+    EXPECT_GE(skip.missed, 4u);
+    EXPECT_LE(skip.runs, 8u);
+    EXPECT_THROW(worker.taskStats("none"), std::out_of_range);
+}
+
+TEST(PersistentWorkerTest, HandlesIdentifyTasks)
+{
+    PersistentWorker worker({.threads = 2});
+
+    std::atomic<int>             runs{0};
+    PersistentWorker::TaskHandle handle = worker.addTask([&] { runs++; });
+    EXPECT_TRUE(handle.valid());
+    EXPECT_FALSE(PersistentWorker::TaskHandle().valid());
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    EXPECT_GT(worker.taskStats(handle).runs, 0u);
+
+    EXPECT_TRUE(worker.removeTask(handle));
+    EXPECT_FALSE(worker.removeTask(handle));
+    EXPECT_THROW(worker.shardOf(handle), std::out_of_range);
+
+    // The slot is reused, but the old handle does not reach the new task.
+    PersistentWorker::TaskHandle reused = worker.addTask([] {});
+    EXPECT_EQ(reused.index, handle.index);
+    EXPECT_NE(reused, handle);
+    EXPECT_FALSE(worker.removeTask(handle));
+    EXPECT_TRUE(worker.removeTask(reused));
+}
+
+TEST(PersistentWorkerTest, NamedTasksHaveHandlesToo)
+{
+    PersistentWorker worker(std::chrono::milliseconds(1));
+
+    PersistentWorker::TaskHandle first  = worker.addTask("task", [] {});
+    PersistentWorker::TaskHandle second = worker.addTask("task", [] {});
+    EXPECT_FALSE(worker.removeTask(first));
+    EXPECT_EQ(worker.shardOf("task"), worker.shardOf(second));
+
+    EXPECT_TRUE(worker.removeTask(second));
+    EXPECT_THROW(worker.shardOf("task"), std::out_of_range);
+}
+
+TEST(PersistentWorkerTest, ManyShortLivedTasks)
+{
+    PersistentWorker worker({.threads = 2});
+
+    std::vector<PersistentWorker::TaskHandle> handles;
+    for (int round = 0; round < 20; ++round)
+    {
+        for (int i = 0; i < 100; ++i)
+            handles.push_back(worker.addTask([] {}, {.interval = std::chrono::milliseconds(5)}));
+        for (auto handle : handles)
+            EXPECT_TRUE(worker.removeTask(handle));
+        handles.clear();
+    }
+    // Every slot went back to the free list and was reused.
+    EXPECT_LT(worker.addTask([] {}).index, 100u);
+}
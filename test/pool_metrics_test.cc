@@ -0,0 +1,121 @@
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <chrono>
+#include <stdexcept>
+#include <string>
+#include <thread>
+
+#include "pool_metrics.hpp"
+#include "worker_pool.hpp"
+
+TEST(LatencyHistogramTest, SmallValuesAreExact)
+{
+    for (uint64_t value = 0; value < (1u << LatencyHistogram::SUB_BITS); ++value)
+        EXPECT_EQ(LatencyHistogram::bucketUpperBound(LatencyHistogram::bucketOf(value)), value);
+}
+
+TEST(LatencyHistogramTest, BucketsBoundValuesWithinPrecision)
+{
+    for (uint64_t value = 1; value < (uint64_t(1) << 39); value = value * 3 + 7)
+    {
+        uint64_t bound = LatencyHistogram::bucketUpperBound(LatencyHistogram::bucketOf(value));
+        EXPECT_GE(bound, value);
+        EXPECT_LE(bound - value, value / (1u << LatencyHistogram::SUB_BITS) + 1);
+    }
+    EXPECT_EQ(LatencyHistogram::bucketOf(UINT64_MAX), LatencyHistogram::BUCKETS - 1);
+}
+
+TEST(LatencyHistogramTest, PercentilesAndMerge)
+{
+    LatencyHistogram low;
+    LatencyHistogram high;
+    for (uint64_t i = 1; i <= 900; ++i)
+        low.record(1000);
+    for (uint64_t i = 1; i <= 100; ++i)
+        high.record(1000000);
+    low.merge(high);
+
+    EXPECT_EQ(low.count(), 1000u);
+    EXPECT_EQ(low.max(), std::chrono::microseconds(1000));
+    EXPECT_NEAR(low.percentile(0.5).count(), 1000, 40);
+    EXPECT_NEAR(low.percentile(0.99).count(), 1000000, 40000);
+    EXPECT_EQ(low.mean(), std::chrono::nanoseconds((900 * 1000 + 100 * 1000000) / 1000));
+    EXPECT_EQ(LatencyHistogram().percentile(0.5).count(), 0);
+}
+
+TEST(PoolMetricsTest, DisabledByDefault)
+{
+    WorkerPool pool(2);
+    pool.submit([] {}).get();
+    EXPECT_FALSE(pool.metricsSnapshot().enabled);
+}
+
+class FailingJob : public WorkerPool::IJob
+{
+public:
+    void execute() override
+    {
+        throw std::runtime_error("boom");
+    }
+};
+
+TEST(PoolMetricsTest, CountsJobsAndTime)
+{
+    if (!WorkerPool::metricsCompiled())
+        GTEST_SKIP() << "built without FTPP_METRICS";
+
+    WorkerPool pool({.workerCount = 2, .metrics = true});
+    for (int i = 0; i < 20; ++i)
+        pool.submit([] { std::this_thread::sleep_for(std::chrono::microseconds(200)); });
+    FailingJob failing;
+    pool.addJob(&failing);
+    pool.waitIdle();
+    EXPECT_EQ(pool.getExceptions().size(), 1u);
+
+    PoolMetricsSnapshot snapshot = pool.metricsSnapshot();
+    EXPECT_TRUE(snapshot.enabled);
+    EXPECT_EQ(snapshot.jobsCompleted, 21u);
+    EXPECT_EQ(snapshot.jobsFailed, 1u);
+    EXPECT_EQ(snapshot.jobsPending, 0u);
+    EXPECT_EQ(snapshot.execution.count(), 21u);
+    EXPECT_EQ(snapshot.queueWait.count(), 21u);
+    EXPECT_GE(snapshot.execution.max(), std::chrono::microseconds(200));
+    ASSERT_EQ(snapshot.workers.size(), 2u);
+
+    uint64_t jobs = 0;
+    for (const auto& worker : snapshot.workers)
+    {
+        jobs += worker.jobs;
+        EXPECT_GE(worker.utilization(), 0.0);
+        EXPECT_LE(worker.utilization(), 1.0);
+    }
+    // waitIdle() helps with the queue, and what it runs belongs to no worker.
+    EXPECT_LE(jobs, 21u);
+    EXPECT_GT(snapshot.throughput(), 0.0);
+    EXPECT_NE(snapshot.toJson().find("\"jobs_completed\":21"), std::string::npos);
+}
+
+// The enqueue time travels beside the job pointer: IJob is the same with or without metrics.
+static_assert(sizeof(WorkerPool::IJob) == sizeof(void*));
+
+TEST(PoolMetricsTest, QueueWaitOnEveryPath)
+{
+    if (!WorkerPool::metricsCompiled())
+        GTEST_SKIP() << "built without FTPP_METRICS";
+
+    WorkerPool pool({.workerCount = 1,
+                     .scheduling  = WorkerPool::Scheduling::WorkStealing,
+                     .metrics     = true});
+    // Injected, routed to a group, prioritized, and pushed on a worker's own deque.
+    pool.submit([] {});
+    pool.submitTo(0, [] {});
+    pool.submit({.priority = WorkerPool::Priority::High}, [] {});
+    pool.submit([&] { pool.submit([] {}); });
+    pool.waitIdle();
+
+    PoolMetricsSnapshot snapshot = pool.metricsSnapshot();
+    EXPECT_EQ(snapshot.queueWait.count(), 5u);
+    // An unstamped job would count the whole uptime of the clock as waiting.
+    EXPECT_LT(snapshot.queueWait.max(), std::chrono::seconds(10));
+}
@@ -0,0 +1,65 @@
+#include <gtest/gtest.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <memory_resource>
+#include <vector>
+
+#include "scratch_arena.hpp"
+
+TEST(ScratchArenaTest, BumpsWithinTheBlock)
+{
+    ScratchArena arena(1024);
+
+    auto* a = arena.make<int>(1);
+    auto* b = arena.make<double>(2.0);
+    EXPECT_EQ(*a, 1);
+    EXPECT_EQ(*b, 2.0);
+    EXPECT_EQ(reinterpret_cast<uintptr_t>(b) % alignof(double), 0u);
+    EXPECT_LE(arena.used(), 24u);
+
+    void* wide = arena.allocate(16, 64);
+    EXPECT_EQ(reinterpret_cast<uintptr_t>(wide) % 64, 0u);
+
+    arena.reset();
+    EXPECT_EQ(arena.used(), 0u);
+    EXPECT_EQ(arena.make<int>(3), a);
+}
+
+TEST(ScratchArenaTest, OverflowGrowsTheBlockOnReset)
+{
+    ScratchArena arena(16);
+
+    std::vector<void*> blocks;
+    for (int i = 0; i < 10; ++i)
+        blocks.push_back(arena.allocate(100, 8));
+    EXPECT_EQ(arena.capacity(), 16u);
+    EXPECT_GE(arena.used(), 1000u);
+
+    arena.reset();
+    EXPECT_GE(arena.capacity(), 1000u);
+    EXPECT_GE(arena.highWater(), 1000u);
+
+    // The same round now fits in the block.
+    blocks.clear();
+    for (int i = 0; i < 10; ++i)
+        blocks.push_back(arena.allocate(100, 8));
+    size_t capacity = arena.capacity();
+    arena.reset();
+    EXPECT_EQ(arena.capacity(), capacity);
+}
+
+TEST(ScratchArenaTest, BacksPmrContainers)
+{
+    ScratchArena arena;
+    {
+        std::pmr::vector<int> values(&arena);
+        for (int i = 0; i < 100; ++i)
+            values.push_back(i);
+        EXPECT_EQ(values[99], 99);
+    }
+    arena.reset();
+    EXPECT_GT(arena.capacity(), 0u);
+    EXPECT_TRUE(arena.is_equal(arena));
+    EXPECT_FALSE(arena.is_equal(*std::pmr::get_default_resource()));
+}
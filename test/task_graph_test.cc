@@ -0,0 +1,98 @@
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <mutex>
+#include <stdexcept>
+#include <vector>
+
+#include "task_graph.hpp"
+#include "worker_pool.hpp"
+
+TEST(TaskGraphTest, RespectsDependencies)
+{
+    WorkerPool pool(4);
+    TaskGraph  graph;
+
+    std::mutex       mtx;
+    std::vector<int> order;
+    auto             record = [&](int id)
+    {
+        return [&, id]()
+        {
+            std::lock_guard<std::mutex> lock(mtx);
+            order.push_back(id);
+        };
+    };
+
+    // 0 -> {1, 2} -> 3
+    auto a = graph.addNode(record(0), "load");
+    auto b = graph.addNode(record(1));
+    auto c = graph.addNode(record(2));
+    auto d = graph.addNode(record(3), "present");
+    graph.precede(a, b);
+    graph.precede(a, c);
+    graph.precede(b, d);
+    graph.precede(c, d);
+
+    graph.run(pool);
+
+    ASSERT_EQ(order.size(), 4u);
+    EXPECT_EQ(order.front(), 0);
+    EXPECT_EQ(order.back(), 3);
+    EXPECT_EQ(graph.name(d), "present");
+}
+
+TEST(TaskGraphTest, ReusableAcrossRuns)
+{
+    WorkerPool pool({.workerCount = 3, .scheduling = WorkerPool::Scheduling::WorkStealing});
+    TaskGraph  graph;
+
+    std::atomic<int>               counter{0};
+    std::vector<TaskGraph::NodeId> chain;
+    for (int i = 0; i < 50; ++i)
+    {
+        // The chain runs strictly in order, interleaved with independent +1000 nodes.
+        chain.push_back(
+            graph.addNode([&counter, i]() { EXPECT_EQ(counter.fetch_add(1) % 1000 % 50, i); }));
+        if (i > 0)
+            graph.precede(chain[i - 1], chain[i]);
+    }
+    for (int i = 0; i < 20; ++i)
+        graph.addNode([&counter]() { counter.fetch_add(1000); });
+
+    for (int frame = 0; frame < 10; ++frame)
+        graph.run(pool);
+    EXPECT_EQ(counter.load(), 10 * (50 + 20 * 1000));
+}
+
+TEST(TaskGraphTest, FailureSkipsSuccessors)
+{
+    WorkerPool pool(2);
+    TaskGraph  graph;
+    bool       successorRan   = false;
+    bool       independentRan = false;
+
+    auto fail = graph.addNode([]() { throw std::runtime_error("stage failed"); });
+    auto next = graph.addNode([&]() { successorRan = true; });
+    graph.addNode([&]() { independentRan = true; });
+    graph.precede(fail, next);
+
+    EXPECT_THROW(graph.run(pool), std::runtime_error);
+    EXPECT_FALSE(successorRan);
+    EXPECT_TRUE(independentRan);
+    EXPECT_TRUE(pool.getExceptions().empty());
+}
+
+TEST(TaskGraphTest, RejectsCycle)
+{
+    WorkerPool pool(1);
+    TaskGraph  graph;
+
+    auto a = graph.addNode([]() {});
+    auto b = graph.addNode([]() {});
+    graph.precede(a, b);
+    graph.precede(b, a);
+
+    EXPECT_THROW(graph.run(pool), std::logic_error);
+    EXPECT_THROW(graph.precede(a, 5), std::out_of_range);
+}
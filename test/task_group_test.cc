@@ -0,0 +1,170 @@
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <stdexcept>
+#include <thread>
+
+#include "cancellation.hpp"
+#include "task_group.hpp"
+#include "worker_pool.hpp"
+
+TEST(TaskGroupTest, WaitForBatchesOnOnePool)
+{
+    WorkerPool pool(4);
+    for (int batch = 0; batch < 10; ++batch)
+    {
+        TaskGroup        group(pool);
+        std::atomic<int> done{0};
+        for (int i = 0; i < 100; ++i)
+            group.run([&] { done++; });
+        group.wait();
+        EXPECT_EQ(done.load(), 100);
+    }
+    EXPECT_EQ(pool.workerCount(), 4u);
+}
+
+TEST(TaskGroupTest, GroupIsReusableAfterWait)
+{
+    WorkerPool       pool({.workerCount = 2, .scheduling = WorkerPool::Scheduling::WorkStealing});
+    TaskGroup        group(pool);
+    std::atomic<int> done{0};
+
+    group.run([&] { done++; });
+    group.wait();
+    group.run([&] { done++; });
+    group.run([&] { done++; });
+    group.wait();
+    EXPECT_EQ(done.load(), 3);
+}
+
+TEST(TaskGroupTest, NestedRunFromJob)
+{
+    WorkerPool       pool(2);
+    TaskGroup        group(pool);
+    std::atomic<int> done{0};
+
+    for (int i = 0; i < 10; ++i)
+    {
+        group.run(
+            [&]
+            {
+                for (int j = 0; j < 10; ++j)
+                    group.run([&] { done++; });
+            });
+    }
+    group.wait();
+    EXPECT_EQ(done.load(), 100);
+}
+
+TEST(TaskGroupTest, ExceptionCancelsAndRethrows)
+{
+    WorkerPool       pool(1);
+    TaskGroup        group(pool);
+    std::atomic<int> ran{0};
+
+    group.run([] { throw std::runtime_error("boom"); });
+    while (!group.isCancelled())
+        std::this_thread::yield();
+    for (int i = 0; i < 10; ++i)
+        group.run([&] { ran++; });
+
+    EXPECT_THROW(group.wait(), std::runtime_error);
+    EXPECT_EQ(ran.load(), 0);
+    EXPECT_NO_THROW(group.wait());
+}
+
+TEST(TaskGroupTest, RunsAgainAfterFailureOrCancel)
+{
+    WorkerPool       pool(2);
+    TaskGroup        group(pool);
+    std::atomic<int> ran{0};
+
+    group.run([] { throw std::runtime_error("boom"); });
+    EXPECT_THROW(group.wait(), std::runtime_error);
+    EXPECT_FALSE(group.isCancelled());
+    group.run([&] { ran++; });
+    EXPECT_NO_THROW(group.wait());
+    EXPECT_EQ(ran.load(), 1);
+
+    group.cancel();
+    group.run([&] { ran++; });
+    group.wait();
+    EXPECT_EQ(ran.load(), 1);
+    group.run([&] { ran++; });
+    group.wait();
+    EXPECT_EQ(ran.load(), 2);
+}
+
+TEST(TaskGroupTest, GroupCanBeDestroyedRightAfterWait)
+{
+    WorkerPool pool(2);
+    for (int i = 0; i < 2000; ++i)
+    {
+        auto group = std::make_unique<TaskGroup>(pool);
+        group->run([] {});
+        group->wait();
+    }
+}
+
+TEST(TaskGroupTest, RunningJobsSeeCancellation)
+{
+    WorkerPool        pool(2);
+    TaskGroup         group(pool);
+    std::atomic<bool> started{false};
+
+    group.run(
+        [&](CancellationToken token)
+        {
+            started = true;
+            while (true)
+            {
+                token.throwIfCancelled();
+                std::this_thread::yield();
+            }
+        });
+    while (!started.load())
+        std::this_thread::yield();
+    group.cancel();
+    EXPECT_NO_THROW(group.wait());
+}
+
+TEST(TaskGroupTest, ParentTokenCancelsGroup)
+{
+    WorkerPool         pool(1);
+    CancellationSource parent;
+    TaskGroup          group(pool, parent.token());
+    std::atomic<bool>  release{false};
+    std::atomic<int>   ran{0};
+
+    group.run(
+        [&]
+        {
+            while (!release.load())
+                std::this_thread::yield();
+        });
+    group.run([&] { ran++; });
+
+    parent.cancel();
+    EXPECT_TRUE(group.isCancelled());
+    EXPECT_TRUE(group.token().isCancelled());
+    release = true;
+    group.wait();
+    EXPECT_EQ(ran.load(), 0);
+    EXPECT_TRUE(group.isCancelled());
+}
+
+TEST(TaskGroupTest, CancellationToken)
+{
+    CancellationToken never;
+    EXPECT_FALSE(never.isCancelled());
+    EXPECT_NO_THROW(never.throwIfCancelled());
+
+    CancellationSource source;
+    CancellationToken  token = source.token();
+    EXPECT_FALSE(token.isCancelled());
+    source.cancel();
+    EXPECT_TRUE(token.isCancelled());
+    EXPECT_THROW(token.throwIfCancelled(), OperationCancelled);
+}
@@ -1,8 +1,13 @@
 #include <gtest/gtest.h>
 
 #include <algorithm>
+#include <cstdint>
+#include <limits>
 #include <regex>
+#include <string>
+#include <string_view>
 #include <thread>
+#include <vector>
 
 #include "thread_safe_iostream.hpp"
 
@@ -211,6 +216,222 @@ TEST(ThreadSafeIOStreamTest, MultithreadTestRegex)
     }
 }
 
+struct Point
+{
+    int x, y;
+};
+
+std::ostream& operator<<(std::ostream& os, const Point& point)
+{
+    return os << "(" << point.x << ", " << point.y << ")";
+}
+
+TEST(ThreadSafeIOStreamTest, FormatsLikeOstream)
+{
+    std::ostringstream expected;
+    auto               both = [&](const auto& value)
+    {
+        expected << value << ' ';
+        ThreadSafeIO << value << ' ';
+    };
+
+    testing::internal::CaptureStdout();
+    ThreadSafeIO.setPrefix("");
+    both(0);
+    both(-42);
+    both(std::numeric_limits<int64_t>::min());
+    both(std::numeric_limits<uint64_t>::max());
+    both(static_cast<short>(-7));
+    both(3.14);
+    both(1.0 / 3);
+    both(-0.0);
+    both(1e20);
+    both(123456789.0);
+    both(2.5f);
+    both(1e-7L);
+    both(true);
+    both('c');
+    both(static_cast<unsigned char>('u'));
+    both(std::string("string"));
+    both(std::string_view("view"));
+    both("literal");
+    both(Point{1, 2});
+    ThreadSafeIO.flush();
+
+    EXPECT_EQ(testing::internal::GetCapturedStdout(), expected.str());
+}
+
+TEST(ThreadSafeIOStreamTest, PrefixesEveryLineOfOneValue)
+{
+    testing::internal::CaptureStdout();
+    ThreadSafeIO.setPrefix("> ");
+    ThreadSafeIO << "one\ntwo\n\nthree" << '\n' << 4 << std::endl;
+    EXPECT_EQ(testing::internal::GetCapturedStdout(), "> one\n> two\n> \n> three\n> 4\n");
+}
+
+TEST(ThreadSafeIOStreamTest, AsyncKeepsEveryLineInThreadOrder)
+{
+    const int num_threads         = 4;
+    const int messages_per_thread = 500;
+
+    testing::internal::CaptureStdout();
+    // A small ring wraps often and makes the producers wait for the writer.
+    ThreadSafeIOStream::enableAsync(256);
+    EXPECT_TRUE(ThreadSafeIOStream::async());
+
+    std::vector<std::thread> threads;
+    for (int i = 0; i < num_threads; ++i)
+    {
+        threads.emplace_back(
+            [i]
+            {
+                ThreadSafeIO.setPrefix("[" + std::to_string(i) + "] ");
+                for (int j = 0; j < messages_per_thread; ++j)
+                    ThreadSafeIO << "message " << j << std::endl;
+            });
+    }
+    for (auto& t : threads)
+        t.join();
+    ThreadSafeIOStream::sync();
+    ThreadSafeIOStream::disableAsync();
+    std::string output = testing::internal::GetCapturedStdout();
+
+    std::regex         line_pattern("\\[([0-9]+)\\] message ([0-9]+)");
+    std::vector<int>   next(num_threads, 0);
+    std::istringstream iss(output);
+    std::string        line;
+    while (std::getline(iss, line))
+    {
+        std::smatch match;
+        ASSERT_TRUE(std::regex_match(line, match, line_pattern)) << line;
+        EXPECT_EQ(std::stoi(match[2]), next[std::stoi(match[1])]++);
+    }
+    for (int count : next)
+        EXPECT_EQ(count, messages_per_thread);
+}
+
+TEST(ThreadSafeIOStreamTest, DisableAsyncWritesEverythingOut)
+{
+    testing::internal::CaptureStdout();
+    ThreadSafeIOStream::enableAsync();
+    ThreadSafeIO.setPrefix("");
+    for (int i = 0; i < 100; ++i)
+        ThreadSafeIO << "Line " << i << std::endl;
+    ThreadSafeIOStream::disableAsync();
+    EXPECT_FALSE(ThreadSafeIOStream::async());
+    ThreadSafeIO << "Synchronous again" << std::endl;
+    std::string output = testing::internal::GetCapturedStdout();
+
+    EXPECT_EQ(std::count(output.begin(), output.end(), '\n'), 101);
+    EXPECT_TRUE(output.ends_with("Line 99\nSynchronous again\n"));
+}
+
+TEST(ThreadSafeIOStreamTest, AsyncThreadHandsOverItsBufferOnExit)
+{
+    testing::internal::CaptureStdout();
+    ThreadSafeIOStream::enableAsync();
+    std::thread(
+        []
+        {
+            ThreadSafeIO.setPrefix("[Exiting] ");
+            ThreadSafeIO << "first" << std::endl << "unflushed\n";
+        })
+        .join();
+    ThreadSafeIOStream::sync();
+    ThreadSafeIOStream::disableAsync();
+    std::string output = testing::internal::GetCapturedStdout();
+
+    EXPECT_EQ(output, "[Exiting] first\n[Exiting] unflushed\n");
+}
+
+TEST(ThreadSafeIOStreamTest, LogFormatsLikeOperatorsWhenSynchronous)
+{
+    testing::internal::CaptureStdout();
+    ThreadSafeIO.setPrefix("[Log] ");
+    std::string name = "pool";
+    ThreadSafeIO.log<"{} ran {} jobs in {} ms ({}, {})">(name, 42, 1.5, 'x', true);
+    ThreadSafeIO.log<"no arguments">();
+    EXPECT_EQ(testing::internal::GetCapturedStdout(),
+              "[Log] pool ran 42 jobs in 1.5 ms (x, 1)\n[Log] no arguments\n");
+}
+
+TEST(ThreadSafeIOStreamTest, LogIsFormattedByTheWriter)
+{
+    const int num_threads         = 4;
+    const int messages_per_thread = 500;
+
+    testing::internal::CaptureStdout();
+    ThreadSafeIOStream::enableAsync(512);
+    std::vector<std::thread> threads;
+    for (int i = 0; i < num_threads; ++i)
+    {
+        threads.emplace_back(
+            [i]
+            {
+                ThreadSafeIO.setPrefix("[" + std::to_string(i) + "] ");
+                for (int j = 0; j < messages_per_thread; ++j)
+                {
+                    if (j % 100 == 0)
+                        ThreadSafeIO << "text " << j << std::endl;
+                    else
+                        ThreadSafeIO.log<"record {} {}">(j, std::string_view("abc", j % 4));
+                }
+            });
+    }
+    for (auto& t : threads)
+        t.join();
+    ThreadSafeIOStream::sync();
+    ThreadSafeIOStream::disableAsync();
+    std::string output = testing::internal::GetCapturedStdout();
+
+    // Records and plain text of one thread come out in the order they were written.
+    std::regex         line_pattern("\\[([0-9]+)\\] (text|record) ([0-9]+)( a?b?c?)?");
+    std::vector<int>   next(num_threads, 0);
+    std::istringstream iss(output);
+    std::string        line;
+    while (std::getline(iss, line))
+    {
+        std::smatch match;
+        ASSERT_TRUE(std::regex_match(line, match, line_pattern)) << line;
+        int j = std::stoi(match[3]);
+        EXPECT_EQ(j, next[std::stoi(match[1])]++);
+        if (match[2] == "record")
+        {
+            EXPECT_EQ(match[4], " " + std::string("abc", j % 4));
+        }
+    }
+    for (int count : next)
+        EXPECT_EQ(count, messages_per_thread);
+}
+
+TEST(ThreadSafeIOStreamTest, LogFollowsPrefixChanges)
+{
+    testing::internal::CaptureStdout();
+    ThreadSafeIOStream::enableAsync();
+    ThreadSafeIO.setPrefix("[A] ");
+    ThreadSafeIO.log<"{}">(1);
+    ThreadSafeIO.setPrefix("[B] ");
+    ThreadSafeIO.log<"{}\n{}">(2, 3);
+    ThreadSafeIOStream::sync();
+    ThreadSafeIOStream::disableAsync();
+    EXPECT_EQ(testing::internal::GetCapturedStdout(), "[A] 1\n[B] 2\n[B] 3\n");
+}
+
+TEST(ThreadSafeIOStreamTest, LogWithoutArgumentsIsDeferredToo)
+{
+    static_assert(FormatString("a {} b {}").placeholders() == 2);
+    static_assert(FormatString("{ } {{}").placeholders() == 1);
+
+    testing::internal::CaptureStdout();
+    ThreadSafeIOStream::enableAsync();
+    ThreadSafeIO.setPrefix("[Plain] ");
+    ThreadSafeIO.log<"plain">();
+    ThreadSafeIO.log<"">();
+    ThreadSafeIOStream::sync();
+    ThreadSafeIOStream::disableAsync();
+    EXPECT_EQ(testing::internal::GetCapturedStdout(), "[Plain] plain\n[Plain] \n");
+}
+
 // TEST(ThreadSafeIOStreamTest, PromptTest)
 // {
 //     // Prépare l'entrée simulée
@@ -0,0 +1,153 @@
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <sstream>
+#include <stop_token>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "persistent_worker.hpp"
+#include "thread.hpp"
+#include "thread_stats.hpp"
+#include "worker_pool.hpp"
+
+namespace
+{
+void spin(std::chrono::milliseconds duration)
+{
+    auto end = std::chrono::steady_clock::now() + duration;
+    while (std::chrono::steady_clock::now() < end)
+    {
+    }
+}
+
+// Threads register once they run, which may be a little after their owner is built.
+std::vector<ThreadStats> waitForThreads(const std::function<std::vector<ThreadStats>()>& get,
+                                        size_t                                           count)
+{
+    auto                     deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+    std::vector<ThreadStats> threads  = get();
+    while (threads.size() < count && std::chrono::steady_clock::now() < deadline)
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        threads = get();
+    }
+    return threads;
+}
+} // namespace
+
+TEST(ThreadStatsTest, CurrentCountsCpuTime)
+{
+    ThreadStats before = ThreadStats::current();
+    spin(std::chrono::milliseconds(20));
+    ThreadStats after = ThreadStats::current();
+
+    EXPECT_GT(after.tid, 0);
+    EXPECT_EQ(after.tid, before.tid);
+    EXPECT_GE(after.cpu - before.cpu, std::chrono::milliseconds(10));
+}
+
+TEST(ThreadStatsTest, SleepingCountsVoluntarySwitches)
+{
+    ThreadStats before = ThreadStats::current();
+    for (int i = 0; i < 5; ++i)
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    ThreadStats after = ThreadStats::current();
+
+    EXPECT_GE(after.voluntarySwitches - before.voluntarySwitches, 5u);
+}
+
+TEST(ThreadStatsTest, RegistryFollowsScopes)
+{
+    int owner = 0;
+    EXPECT_TRUE(ThreadRegistry::instance().snapshot(&owner).empty());
+    {
+        ThreadRegistry::Scope    registration("scoped", &owner);
+        std::vector<ThreadStats> threads = ThreadRegistry::instance().snapshot(&owner);
+        ASSERT_EQ(threads.size(), 1u);
+        EXPECT_EQ(threads[0].name, "scoped");
+        EXPECT_TRUE(threads[0].running);
+
+        std::ostringstream dump;
+        ThreadRegistry::instance().dump(dump);
+        EXPECT_NE(dump.str().find("scoped"), std::string::npos);
+        EXPECT_NE(ThreadRegistry::instance().toJson().find("\"name\":\"scoped\""),
+                  std::string::npos);
+    }
+    EXPECT_TRUE(ThreadRegistry::instance().snapshot(&owner).empty());
+}
+
+TEST(ThreadStatsTest, SamplesOtherThreads)
+{
+    int               owner = 0;
+    std::atomic<bool> done(false);
+    std::thread       busy(
+        [&]
+        {
+            ThreadRegistry::Scope registration("busy", &owner);
+            spin(std::chrono::milliseconds(20));
+            while (!done.load())
+                std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        });
+
+    std::vector<ThreadStats> threads =
+        waitForThreads([&] { return ThreadRegistry::instance().snapshot(&owner); }, 1);
+    ASSERT_EQ(threads.size(), 1u);
+    std::this_thread::sleep_for(std::chrono::milliseconds(40));
+    threads = ThreadRegistry::instance().snapshot(&owner);
+    done.store(true);
+    busy.join();
+
+    ASSERT_EQ(threads.size(), 1u);
+    EXPECT_GE(threads[0].cpu, std::chrono::milliseconds(10));
+    EXPECT_GE(threads[0].wall, std::chrono::milliseconds(40));
+    EXPECT_GT(threads[0].voluntarySwitches, 0u);
+}
+
+TEST(ThreadStatsTest, ThreadKeepsItsLastSample)
+{
+    Thread thread("stats", [](std::stop_token) { spin(std::chrono::milliseconds(20)); });
+    EXPECT_FALSE(thread.stats().running);
+
+    thread.start();
+    thread.stop();
+    ThreadStats stats = thread.stats();
+    EXPECT_FALSE(stats.running);
+    EXPECT_EQ(stats.name, "stats");
+    EXPECT_GE(stats.cpu, std::chrono::milliseconds(10));
+    EXPECT_GE(stats.wall, std::chrono::milliseconds(20));
+}
+
+TEST(ThreadStatsTest, ThreadIsLiveWhileRunning)
+{
+    Thread thread("live",
+                  [](std::stop_token token)
+                  {
+                      while (!token.stop_requested())
+                          std::this_thread::sleep_for(std::chrono::milliseconds(1));
+                  });
+    thread.start();
+    ThreadStats stats;
+    auto        deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+    while (!(stats = thread.stats()).running && std::chrono::steady_clock::now() < deadline)
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    thread.stop();
+
+    EXPECT_TRUE(stats.running);
+    EXPECT_EQ(stats.name, "live");
+}
+
+TEST(ThreadStatsTest, PoolsListTheirThreads)
+{
+    WorkerPool               pool({.workerCount = 2, .name = "stats"});
+    std::vector<ThreadStats> workers = waitForThreads([&] { return pool.threadStats(); }, 2);
+    ASSERT_EQ(workers.size(), 2u);
+    for (const ThreadStats& stats : workers)
+        EXPECT_TRUE(stats.name == "stats-0" || stats.name == "stats-1") << stats.name;
+
+    PersistentWorker persistent(PersistentWorker::Options{.threads = 3, .name = "ticker"});
+    EXPECT_EQ(waitForThreads([&] { return persistent.threadStats(); }, 3).size(), 3u);
+}
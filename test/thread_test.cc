@@ -1,4 +1,17 @@
 #include <gtest/gtest.h>
+#include <pthread.h>
+#include <sched.h>
+#include <sys/resource.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <chrono>
+#include <memory_resource>
+#include <stdexcept>
+#include <stop_token>
+#include <string>
+#include <thread>
+#include <vector>
 
 #include "thread.hpp"
 #include "thread_safe_iostream.hpp"
@@ -34,3 +47,125 @@ TEST(ThreadTest, MultipleThreads)
 
     SUCCEED();
 }
+
+TEST(ThreadTest, StopRequestsReachTheFunction)
+{
+    std::atomic<int> spins{0};
+    Thread           thread("[Stoppable] ",
+                  [&](std::stop_token token)
+                  {
+                      while (!token.stop_requested())
+                          spins++;
+                  });
+
+    thread.start();
+    while (spins.load() == 0)
+        std::this_thread::yield();
+    EXPECT_FALSE(thread.stopToken().stop_requested());
+    thread.stop();
+    EXPECT_TRUE(thread.stopToken().stop_requested());
+    EXPECT_FALSE(thread.requestStop());
+}
+
+TEST(ThreadTest, DestructorStopsAndJoins)
+{
+    std::atomic<bool> finished{false};
+    {
+        Thread thread("[Scoped] ",
+                      [&](std::stop_token token)
+                      {
+                          while (!token.stop_requested())
+                              std::this_thread::sleep_for(std::chrono::milliseconds(1));
+                          finished = true;
+                      });
+        thread.start();
+    }
+    EXPECT_TRUE(finished.load());
+}
+
+TEST(ThreadTest, RepeatResetsTheScratchArena)
+{
+    std::atomic<int>    iterations{0};
+    std::atomic<size_t> capacity{0};
+    std::atomic<bool>   emptyAtStart{true};
+    Thread              thread(
+        "[Loop] ",
+        [&](std::stop_token)
+        {
+            ScratchArena& arena = Thread::scratch();
+            if (arena.used() != 0)
+                emptyAtStart = false;
+            std::pmr::vector<int> values(&arena);
+            for (int i = 0; i < 1000; ++i)
+                values.push_back(i);
+            capacity = arena.capacity();
+            iterations++;
+        },
+        {.repeat = true, .scratchSize = 64});
+
+    thread.start();
+    while (iterations.load() < 10)
+        std::this_thread::yield();
+    thread.stop();
+
+    EXPECT_TRUE(emptyAtStart.load());
+    // The arena grew to fit one iteration after the first overflowed.
+    EXPECT_GE(capacity.load(), 1000 * sizeof(int));
+    EXPECT_THROW(Thread::scratch(), std::logic_error);
+}
+
+TEST(ThreadTest, AttributesAreInPlaceBeforeTheFunction)
+{
+    cpu_set_t allowed;
+    sched_getaffinity(0, sizeof(allowed), &allowed);
+    int cpu = 0;
+    while (!CPU_ISSET(cpu, &allowed))
+        ++cpu;
+
+    std::string name;
+    int         nice   = 0;
+    size_t      stack  = 0;
+    bool        pinned = false;
+    Thread      thread(
+        "[Attributes] ",
+        [&](std::stop_token)
+        {
+            char buffer[16] = {};
+            pthread_getname_np(pthread_self(), buffer, sizeof(buffer));
+            name = buffer;
+            nice = getpriority(PRIO_PROCESS, static_cast<id_t>(gettid()));
+
+            pthread_attr_t attr;
+            pthread_getattr_np(pthread_self(), &attr);
+            pthread_attr_getstacksize(&attr, &stack);
+            pthread_attr_destroy(&attr);
+
+            cpu_set_t set;
+            pthread_getaffinity_np(pthread_self(), sizeof(set), &set);
+            pinned = CPU_COUNT(&set) == 1 && CPU_ISSET(cpu, &set);
+        },
+        {.cpus = {cpu}, .nice = 5, .stackSize = 1 << 20, .osName = "attributes-thread"});
+
+    thread.start();
+    thread.stop();
+    EXPECT_EQ(name, "attributes-thre");
+    EXPECT_EQ(nice, 5);
+    EXPECT_GE(stack, size_t(1) << 20);
+    EXPECT_TRUE(pinned);
+}
+
+TEST(ThreadTest, RealTimePolicyFallsBackWhenRefused)
+{
+    std::atomic<int> policy{-1};
+    Thread           thread("[RealTime] ",
+                            [&](std::stop_token) { policy = sched_getscheduler(0); },
+                            {.scheduling = Thread::Scheduling::Fifo, .priority = 10});
+
+    thread.start();
+    thread.stop();
+    // Either the process may use SCHED_FIFO or the thread quietly stayed normal.
+    if (thread.scheduling() == Thread::Scheduling::Fifo)
+        EXPECT_EQ(policy.load(), SCHED_FIFO);
+    else
+        EXPECT_EQ(policy.load(), SCHED_OTHER);
+}
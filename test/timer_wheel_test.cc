@@ -0,0 +1,122 @@
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <random>
+#include <vector>
+
+#include "timer_wheel.hpp"
+
+TEST(TimerWheelTest, FiresAtTheScheduledTick)
+{
+    TimerWheel                     wheel;
+    TimerWheel::Node               near, far;
+    std::vector<TimerWheel::Node*> expired;
+
+    wheel.schedule(near, 10);
+    wheel.schedule(far, 5000);
+    EXPECT_EQ(wheel.size(), 2u);
+    EXPECT_EQ(wheel.nextExpiry(), 10u);
+
+    wheel.advance(9, expired);
+    EXPECT_TRUE(expired.empty());
+    wheel.advance(10, expired);
+    ASSERT_EQ(expired.size(), 1u);
+    EXPECT_EQ(expired[0], &near);
+    EXPECT_FALSE(near.scheduled());
+
+    expired.clear();
+    wheel.advance(4999, expired);
+    EXPECT_TRUE(expired.empty());
+    EXPECT_LE(wheel.nextExpiry(), 5000u);
+    wheel.advance(100000, expired);
+    ASSERT_EQ(expired.size(), 1u);
+    EXPECT_EQ(expired[0], &far);
+    EXPECT_TRUE(wheel.empty());
+    EXPECT_EQ(wheel.nextExpiry(), TimerWheel::NEVER);
+}
+
+TEST(TimerWheelTest, PastTicksFireOnNextAdvance)
+{
+    TimerWheel                     wheel(100);
+    TimerWheel::Node               node;
+    std::vector<TimerWheel::Node*> expired;
+
+    wheel.schedule(node, 50);
+    EXPECT_EQ(wheel.nextExpiry(), 100u);
+    wheel.advance(100, expired);
+    EXPECT_EQ(expired.size(), 1u);
+}
+
+TEST(TimerWheelTest, CancelAndReschedule)
+{
+    TimerWheel                     wheel;
+    TimerWheel::Node               a, b;
+    std::vector<TimerWheel::Node*> expired;
+
+    wheel.schedule(a, 100);
+    wheel.schedule(b, 200);
+    wheel.cancel(a);
+    wheel.schedule(b, 300);
+    EXPECT_EQ(wheel.size(), 1u);
+    EXPECT_FALSE(a.scheduled());
+
+    wheel.advance(299, expired);
+    EXPECT_TRUE(expired.empty());
+    wheel.advance(300, expired);
+    EXPECT_EQ(expired.size(), 1u);
+}
+
+TEST(TimerWheelTest, MatchesBruteForceAcrossLevels)
+{
+    std::mt19937_64                rng(42);
+    std::vector<TimerWheel::Node>  nodes(2000);
+    TimerWheel                     wheel;
+    std::vector<bool>              armed(nodes.size(), false);
+    std::vector<TimerWheel::Node*> expired;
+
+    uint64_t now = 0;
+    for (int round = 0; round < 200; ++round)
+    {
+        for (int i = 0; i < 50; ++i)
+        {
+            size_t   index = rng() % nodes.size();
+            unsigned scale = rng() % 40;
+            uint64_t delay = rng() % (uint64_t(1) << scale);
+            if (rng() % 5 == 0)
+            {
+                wheel.cancel(nodes[index]);
+                armed[index] = false;
+            }
+            else
+            {
+                wheel.schedule(nodes[index], now + delay);
+                armed[index] = true;
+            }
+        }
+
+        uint64_t next = wheel.nextExpiry();
+        now += rng() % (uint64_t(1) << (rng() % 34));
+        expired.clear();
+        wheel.advance(now, expired);
+
+        for (TimerWheel::Node* node : expired)
+        {
+            size_t index = node - nodes.data();
+            ASSERT_TRUE(armed[index]);
+            ASSERT_LE(node->expires(), now);
+            ASSERT_GE(node->expires(), next);
+            armed[index] = false;
+        }
+        size_t count = 0;
+        for (size_t i = 0; i < nodes.size(); ++i)
+        {
+            ASSERT_EQ(nodes[i].scheduled(), armed[i]);
+            if (armed[i])
+            {
+                ASSERT_GT(nodes[i].expires(), now);
+                ++count;
+            }
+        }
+        ASSERT_EQ(wheel.size(), count);
+    }
+}
@@ -1,6 +1,22 @@
 
 #include <gtest/gtest.h>
 
+#include <pthread.h>
+#include <sched.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "cpu_topology.hpp"
 #include "worker_pool.hpp"
 
 class TestJob : public WorkerPool::IJob
@@ -68,3 +84,524 @@ TEST(WorkerPoolTest, NoJobs)
     auto exceptions = pool.getExceptions();
     EXPECT_TRUE(exceptions.empty());
 }
+
+class SpawningJob : public WorkerPool::IJob
+{
+public:
+    SpawningJob(WorkerPool& pool, std::atomic<int>& counter, int depth)
+        : pool(pool), counter(counter), depth(depth)
+    {
+    }
+    void execute() override
+    {
+        counter.fetch_add(1);
+        if (depth == 0)
+            return;
+        children.reserve(2);
+        for (int i = 0; i < 2; ++i)
+        {
+            children.push_back(std::make_unique<SpawningJob>(pool, counter, depth - 1));
+            pool.addJob(children.back().get());
+        }
+    }
+    WorkerPool&                               pool;
+    std::atomic<int>&                         counter;
+    int                                       depth;
+    std::vector<std::unique_ptr<SpawningJob>> children;
+};
+
+TEST(WorkerPoolTest, WorkStealingBasicFunctionality)
+{
+    std::vector<TestJob*> jobs;
+    {
+        WorkerPool pool({.workerCount = 4, .scheduling = WorkerPool::Scheduling::WorkStealing});
+        for (int i = 0; i < 10; ++i)
+        {
+            bool shouldThrow = (i % 3 == 0);
+            jobs.push_back(new TestJob(i, shouldThrow));
+            pool.addJob(jobs.back());
+        }
+
+        std::this_thread::sleep_for(std::chrono::milliseconds(200));
+        EXPECT_EQ(pool.getExceptions().size(), 4);
+    }
+
+    for (auto job : jobs)
+        delete job;
+}
+
+TEST(WorkerPoolTest, WorkStealingNestedJobs)
+{
+    std::atomic<int> counter{0};
+    // The job tree must outlive the pool: its destructor drains every job, including the ones
+    // spawned from inside jobs.
+    std::unique_ptr<SpawningJob> root;
+    {
+        WorkerPool pool({.workerCount = 4, .scheduling = WorkerPool::Scheduling::WorkStealing});
+        root = std::make_unique<SpawningJob>(pool, counter, 10);
+        pool.addJob(root.get());
+    }
+    EXPECT_EQ(counter.load(), (1 << 11) - 1);
+}
+
+TEST(WorkerPoolTest, WorkStealingDrainsOnDestruction)
+{
+    std::atomic<int> counter{0};
+    class CountingJob : public WorkerPool::IJob
+    {
+    public:
+        CountingJob(std::atomic<int>& counter) : counter(counter) {}
+        void execute() override
+        {
+            counter.fetch_add(1);
+        }
+        std::atomic<int>& counter;
+    };
+
+    std::vector<std::unique_ptr<CountingJob>> counting;
+    for (int i = 0; i < 1000; ++i)
+        counting.push_back(std::make_unique<CountingJob>(counter));
+    {
+        WorkerPool pool({.workerCount = 3, .scheduling = WorkerPool::Scheduling::WorkStealing});
+        for (auto& job : counting)
+            pool.addJob(job.get());
+    }
+    EXPECT_EQ(counter.load(), 1000);
+}
+
+TEST(WorkerPoolTest, SubmitReturnsResult)
+{
+    WorkerPool pool(4);
+
+    std::vector<Future<int>> futures;
+    for (int i = 0; i < 100; ++i)
+        futures.push_back(pool.submit([](int a, int b) { return a * b; }, i, 2));
+
+    for (int i = 0; i < 100; ++i)
+        EXPECT_EQ(futures[i].get(), i * 2);
+}
+
+TEST(WorkerPoolTest, SubmitPropagatesExceptionPerTask)
+{
+    WorkerPool pool(2);
+
+    Future<void> ok   = pool.submit([]() {});
+    Future<int>  fail = pool.submit([]() -> int { throw std::runtime_error("task failed"); });
+
+    EXPECT_NO_THROW(ok.get());
+    EXPECT_THROW(fail.get(), std::runtime_error);
+    EXPECT_TRUE(pool.getExceptions().empty());
+}
+
+TEST(WorkerPoolTest, SubmitMoveOnlyArguments)
+{
+    WorkerPool pool({.workerCount = 2, .scheduling = WorkerPool::Scheduling::WorkStealing});
+
+    auto        value  = std::make_unique<std::string>("unique");
+    Future<int> future = pool.submit([](std::unique_ptr<std::string> str)
+                                     { return static_cast<int>(str->size()); },
+                                     std::move(value));
+    EXPECT_EQ(future.get(), 6);
+}
+
+TEST(WorkerPoolTest, PlacementPinsAndNamesWorkers)
+{
+    for (auto scheduling : {WorkerPool::Scheduling::Shared, WorkerPool::Scheduling::WorkStealing})
+    {
+        WorkerPool pool({.workerCount = 4,
+                         .scheduling  = scheduling,
+                         .placement   = WorkerPool::Placement::Cache,
+                         .name        = "placed"});
+        ASSERT_GE(pool.groupCount(), 1u);
+
+        for (size_t group = 0; group < pool.groupCount(); ++group)
+        {
+            auto probe = pool.submitTo(group,
+                                       [&]
+                                       {
+                                           char name[16] = {};
+                                           pthread_getname_np(pthread_self(), name, sizeof(name));
+
+                                           cpu_set_t set;
+                                           CPU_ZERO(&set);
+                                           pthread_getaffinity_np(
+                                               pthread_self(), sizeof(set), &set);
+                                           EXPECT_EQ(CPU_COUNT(&set), 1);
+                                           EXPECT_EQ(std::string(name, 7), "placed-");
+                                           return pool.currentGroup();
+                                       });
+            EXPECT_EQ(probe.get(), group);
+        }
+        EXPECT_EQ(pool.currentGroup(), WorkerPool::NO_GROUP);
+    }
+}
+
+TEST(WorkerPoolTest, RoutedJobsStayInGroup)
+{
+    WorkerPool pool({.workerCount = 4, .placement = WorkerPool::Placement::Core});
+
+    std::atomic<int> wrongGroup{0};
+    std::atomic<int> done{0};
+    for (int i = 0; i < 1000; ++i)
+    {
+        size_t group = i % pool.groupCount();
+        pool.submitTo(group,
+                      [&, group]
+                      {
+                          if (pool.currentGroup() != group)
+                              wrongGroup++;
+                          done++;
+                      });
+    }
+    while (done.load() != 1000)
+        std::this_thread::yield();
+    EXPECT_EQ(wrongGroup.load(), 0);
+    EXPECT_THROW(pool.addJob(nullptr, pool.groupCount()), std::out_of_range);
+}
+
+TEST(WorkerPoolTest, PlacementUsesDistinctCoresFirst)
+{
+    CpuTopology        topology;
+    size_t             cores = std::min<size_t>(topology.coreCount(), 4);
+    std::map<int, int> coreOf;
+    for (const CpuTopology::Cpu& cpu : topology.cpus())
+        coreOf[cpu.id] = cpu.core;
+
+    for (auto placement : {WorkerPool::Placement::Core, WorkerPool::Placement::Cache})
+    {
+        WorkerPool    pool({.workerCount = cores, .placement = placement});
+        std::set<int> used;
+        for (size_t i = 0; i < cores; ++i)
+            used.insert(coreOf[pool.workerCpu(i)]);
+        EXPECT_EQ(used.size(), cores);
+    }
+}
+
+TEST(WorkerPoolTest, DefaultPoolHasOneUnpinnedGroup)
+{
+    WorkerPool pool(3);
+    EXPECT_EQ(pool.groupCount(), 1u);
+    for (size_t i = 0; i < pool.workerCount(); ++i)
+    {
+        EXPECT_EQ(pool.workerGroup(i), 0u);
+        EXPECT_EQ(pool.workerCpu(i), -1);
+    }
+}
+
+TEST(WorkerPoolTest, ElasticPoolGrowsAndShrinks)
+{
+    for (auto scheduling : {WorkerPool::Scheduling::Shared, WorkerPool::Scheduling::WorkStealing})
+    {
+        WorkerPool pool({.workerCount = 1,
+                         .scheduling  = scheduling,
+                         .maxWorkers  = 4,
+                         .spawnDepth  = 1,
+                         .idleTimeout = std::chrono::milliseconds(20)});
+        EXPECT_EQ(pool.workerCount(), 1u);
+
+        // Jobs that block until released keep every worker busy, so the queue backs up.
+        std::atomic<bool> release{false};
+        std::atomic<int>  done{0};
+        auto              deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+        int               added    = 0;
+        while (pool.workerCount() < 4 && std::chrono::steady_clock::now() < deadline)
+        {
+            pool.submit(
+                [&]
+                {
+                    while (!release.load())
+                        std::this_thread::yield();
+                    done++;
+                });
+            ++added;
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        EXPECT_EQ(pool.workerCount(), 4u);
+
+        release = true;
+        while (done.load() != added)
+            std::this_thread::yield();
+
+        deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+        while (pool.workerCount() > 1 && std::chrono::steady_clock::now() < deadline)
+            std::this_thread::sleep_for(std::chrono::milliseconds(5));
+        EXPECT_EQ(pool.workerCount(), 1u);
+
+        size_t spawned = 0;
+        size_t retired = 0;
+        for (const auto& event : pool.getScalingEvents())
+        {
+            if (event.spawned)
+            {
+                EXPECT_NE(event.reason, WorkerPool::ScalingEvent::Reason::IdleTimeout);
+                spawned++;
+            }
+            else
+            {
+                EXPECT_EQ(event.reason, WorkerPool::ScalingEvent::Reason::IdleTimeout);
+                retired++;
+            }
+        }
+        EXPECT_GE(spawned, 3u);
+        EXPECT_EQ(spawned, retired);
+        EXPECT_TRUE(pool.getScalingEvents().empty());
+
+        // Retired slots are reused.
+        EXPECT_EQ(pool.submit([] { return 7; }).get(), 7);
+    }
+}
+
+TEST(WorkerPoolTest, ElasticPoolGrowsForRoutedJobs)
+{
+    for (auto scheduling : {WorkerPool::Scheduling::Shared, WorkerPool::Scheduling::WorkStealing})
+    {
+        WorkerPool pool({.workerCount = 1,
+                         .scheduling  = scheduling,
+                         .maxWorkers  = 4,
+                         .spawnDepth  = 1,
+                         .idleTimeout = std::chrono::milliseconds(20)});
+
+        std::atomic<bool> release{false};
+        std::atomic<int>  done{0};
+        auto              deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+        int               added    = 0;
+        while (pool.workerCount() < 4 && std::chrono::steady_clock::now() < deadline)
+        {
+            pool.submitTo(0,
+                          [&]
+                          {
+                              while (!release.load())
+                                  std::this_thread::yield();
+                              done++;
+                          });
+            ++added;
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        EXPECT_EQ(pool.workerCount(), 4u);
+
+        release = true;
+        while (done.load() != added)
+            std::this_thread::yield();
+    }
+}
+
+TEST(WorkerPoolTest, DroppedFuturesGoBackToTheSubmitter)
+{
+    WorkerPool       pool(2);
+    std::atomic<int> done{0};
+
+    // The submitting thread may exit before the workers release its nodes.
+    for (int round = 0; round < 10; ++round)
+    {
+        std::thread submitter(
+            [&]
+            {
+                for (int i = 0; i < 500; ++i)
+                    pool.submit([&] { done++; });
+            });
+        submitter.join();
+    }
+    for (int i = 0; i < 5000; ++i)
+        pool.submit([&] { done++; });
+    pool.waitIdle();
+    EXPECT_EQ(done.load(), 10000);
+    EXPECT_EQ(pool.submit([] { return 7; }).get(), 7);
+}
+
+TEST(WorkerPoolTest, FixedPoolDoesNotScale)
+{
+    WorkerPool       pool(2);
+    std::atomic<int> done{0};
+    for (int i = 0; i < 1000; ++i)
+        pool.submit([&] { done++; });
+    while (done.load() != 1000)
+        std::this_thread::yield();
+    EXPECT_EQ(pool.workerCount(), 2u);
+    EXPECT_TRUE(pool.getScalingEvents().empty());
+}
+
+namespace
+{
+// Holds the only worker of %pool until the returned flag is set.
+std::shared_ptr<std::atomic<bool>> blockWorker(WorkerPool& pool)
+{
+    auto release = std::make_shared<std::atomic<bool>>(false);
+    auto started = std::make_shared<std::atomic<bool>>(false);
+    pool.submit(
+        [release, started]
+        {
+            started->store(true);
+            while (!release->load())
+                std::this_thread::yield();
+        });
+    while (!started->load())
+        std::this_thread::yield();
+    return release;
+}
+} // namespace
+
+TEST(WorkerPoolTest, PriorityOrder)
+{
+    using Priority = WorkerPool::Priority;
+    WorkerPool pool({.workerCount = 1, .recordQueueStats = true});
+    auto       release = blockWorker(pool);
+
+    std::mutex                mtx;
+    std::vector<Priority>     order;
+    std::vector<Future<void>> futures;
+    for (Priority priority : {Priority::Low, Priority::Normal, Priority::High, Priority::Urgent})
+    {
+        futures.push_back(pool.submit({.priority = priority},
+                                      [&, priority]
+                                      {
+                                          std::lock_guard<std::mutex> lock(mtx);
+                                          order.push_back(priority);
+                                      }));
+    }
+    release->store(true);
+    for (auto& future : futures)
+        future.get();
+
+    EXPECT_EQ(order,
+              (std::vector<Priority>{
+                  Priority::Urgent, Priority::High, Priority::Normal, Priority::Low}));
+    EXPECT_EQ(pool.queueStats(Priority::Urgent).count, 1u);
+    EXPECT_EQ(pool.queueStats(Priority::Low).count, 1u);
+}
+
+TEST(WorkerPoolTest, AgingPreventsStarvation)
+{
+    using Priority = WorkerPool::Priority;
+    WorkerPool pool({.workerCount = 1,
+                     .aging       = {std::chrono::microseconds(0),
+                                     std::chrono::microseconds(0),
+                                     std::chrono::microseconds(0),
+                                     std::chrono::milliseconds(1)}});
+    auto       release = blockWorker(pool);
+
+    std::vector<int> order;
+    auto             low = pool.submit({.priority = Priority::Low}, [&] { order.push_back(0); });
+    std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    auto urgent = pool.submit({.priority = Priority::Urgent}, [&] { order.push_back(1); });
+
+    release->store(true);
+    low.get();
+    urgent.get();
+    EXPECT_EQ(order, (std::vector<int>{0, 1}));
+}
+
+TEST(WorkerPoolTest, PlainJobsQueuedBeforePrioritiesKeepTheirPlace)
+{
+    using Priority = WorkerPool::Priority;
+    WorkerPool pool({.workerCount = 1,
+                     .aging       = {std::chrono::microseconds(0),
+                                     std::chrono::microseconds(0),
+                                     std::chrono::milliseconds(1),
+                                     std::chrono::microseconds(0)}});
+    auto       release = blockWorker(pool);
+
+    // The plain job was not timestamped; it still ages from when ordering began.
+    std::vector<int> order;
+    auto             plain = pool.submit([&] { order.push_back(0); });
+    std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    auto high = pool.submit({.priority = Priority::High}, [&] { order.push_back(1); });
+    auto more = pool.submit([&] { order.push_back(2); });
+
+    release->store(true);
+    plain.get();
+    high.get();
+    more.get();
+    EXPECT_EQ(order, (std::vector<int>{1, 0, 2}));
+    EXPECT_EQ(pool.queueStats(Priority::Normal).count, 0u);
+}
+
+TEST(WorkerPoolTest, DeadlinesAndStats)
+{
+    using Priority = WorkerPool::Priority;
+    for (auto scheduling : {WorkerPool::Scheduling::Shared, WorkerPool::Scheduling::WorkStealing})
+    {
+        WorkerPool pool({.workerCount = 1, .scheduling = scheduling, .recordQueueStats = true});
+        auto       release = blockWorker(pool);
+
+        std::vector<int> order;
+        auto urgent = pool.submit({.priority = Priority::Urgent}, [&] { order.push_back(0); });
+        auto late   = pool.submit({.priority = Priority::Low,
+                                   .deadline = std::chrono::steady_clock::now() -
+                                               std::chrono::milliseconds(1)},
+                                [&] { order.push_back(1); });
+
+        std::this_thread::sleep_for(std::chrono::milliseconds(2));
+        release->store(true);
+        urgent.get();
+        late.get();
+        EXPECT_EQ(order, (std::vector<int>{1, 0}));
+
+        WorkerPool::QueueStats low = pool.queueStats(Priority::Low);
+        EXPECT_EQ(low.count, 1u);
+        EXPECT_EQ(low.missedDeadlines, 1u);
+        EXPECT_GE(low.max, std::chrono::milliseconds(2));
+        EXPECT_LE(low.percentile(0.5), low.max);
+        EXPECT_EQ(low.mean(), low.total);
+
+        pool.resetQueueStats();
+        EXPECT_EQ(pool.queueStats(Priority::Low).count, 0u);
+    }
+}
+
+TEST(WorkerPoolTest, WaitIdleKeepsWorkers)
+{
+    for (auto scheduling : {WorkerPool::Scheduling::Shared, WorkerPool::Scheduling::WorkStealing})
+    {
+        WorkerPool pool({.workerCount = 3, .scheduling = scheduling});
+        for (int batch = 0; batch < 5; ++batch)
+        {
+            std::atomic<int> done{0};
+            for (int i = 0; i < 200; ++i)
+            {
+                pool.submit(
+                    [&]
+                    {
+                        pool.submit([&] { done++; });
+                        done++;
+                    });
+            }
+            pool.waitIdle();
+            EXPECT_EQ(done.load(), 400);
+        }
+
+        auto inner = pool.submit(
+            [&]
+            {
+                try
+                {
+                    pool.waitIdle();
+                }
+                catch (const std::logic_error&)
+                {
+                    return true;
+                }
+                return false;
+            });
+        EXPECT_TRUE(inner.get());
+    }
+}
+
+TEST(WorkerPoolTest, WaitPolicies)
+{
+    for (WaitPolicy policy : {WaitPolicy{0, 0}, WaitPolicy{}, WaitPolicy{100000, 100}})
+    {
+        for (auto scheduling :
+             {WorkerPool::Scheduling::Shared, WorkerPool::Scheduling::WorkStealing})
+        {
+            WorkerPool pool({.workerCount = 2, .scheduling = scheduling, .wait = policy});
+            int        total = 0;
+            for (int i = 0; i < 200; ++i)
+            {
+                total += pool.submit([i] { return i; }).get();
+                if (i % 50 == 0)
+                    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            }
+            EXPECT_EQ(total, 199 * 200 / 2);
+        }
+    }
+}